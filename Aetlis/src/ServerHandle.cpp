@@ -57,6 +57,7 @@ void ServerHandle::loadSettings() {
 	LOAD_INT(listenerMaxConnectionsPerIP);
 	LOAD_FLOAT(worldEatMult);
 	LOAD_FLOAT(worldEatOverlapDiv);
+	LOAD_FLOAT(worldEatBulkSize);
 	LOAD_INT(worldSafeSpawnTries);
 	LOAD_FLOAT(worldSafeSpawnFromEjectedChance);
 	LOAD_INT(worldPlayerDisposeDelay);
@@ -211,7 +212,7 @@ void ServerHandle::onTick() {
 	timing.routerTotal = stopwatch.lap();
 
 	for (auto [_, world] : worlds)
-		world->clearTruck();
+		world->releaseCells();
 
 	chatCommands.process();
 	commands.process();
@@ -44,6 +44,7 @@ struct RuntimeSettings {
 	float minionSpawnSize;
 	float worldEatMult;
 	float worldEatOverlapDiv;
+	float worldEatBulkSize;
 	int worldSafeSpawnTries;
 	float worldSafeSpawnFromEjectedChance;
 	int worldPlayerDisposeDelay;
@@ -110,10 +111,25 @@ struct TimingMatrix {
 	float updatePC = 0.0f;
 	float sortCell = 0.0f;
 	float quadTree = 0.0f;
+	float groupSolve = 0.0f;
 	float queryOPs = 0.0f;
 	float rgdCheck = 0.0f;
 	float eatCheck = 0.0f;
 	float viewarea = 0.0f;
+	float mortonSort = 0.0f;
+	float finderBuild = 0.0f;
+	float finderNodes = 0.0f;
+	float finderDepth = 0.0f;
+	float itemsPerLeaf = 0.0f;
+	float nodesPerQuery = 0.0f;
+	float finderSplits = 0.0f;
+	float finderMerges = 0.0f;
+	float finderMaxItems = 0.0f;
+	float finderMaxLevel = 0.0f;
+	float bulkEat = 0.0f;
+	float neighbourReuse = 0.0f;
+	float neighbourRebuilds = 0.0f;
+	float neighbourPushes = 0.0f;
 };
 
 class ServerHandle {
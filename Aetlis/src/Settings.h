@@ -43,14 +43,21 @@ inline Json GAME_CONFIG = R"(
     "worldMapY" : 0,
     "worldMapW" : 7071,
     "worldMapH" : 7071,
+    "worldFinderType" : "quadtree",
     "worldFinderMaxLevel" : 16,
     "worldFinderMaxItems" : 16,
     "worldFinderMaxSearch" : 0,
+    "worldFinderLooseness" : 1.0,
+    "worldFinderCellSize" : 256,
+    "worldFinderRebuild" : false,
+    "worldFinderAutoTune" : false,
+    "worldVerletSkin" : 0,
     "worldSafeSpawnTries" : 128,
     "worldSafeSpawnFromEjectedChance" : 0.8,
     "worldPlayerDisposeDelay" : 100,
     "worldEatMult" : 1.140175425099138,
     "worldEatOverlapDiv" : 3,
+    "worldEatBulkSize" : 1000,
     "worldPlayerBotsPerWorld" : 0,
     "worldPlayerBotNames" : [] ,
     "worldPlayerBotSkins" : [] ,
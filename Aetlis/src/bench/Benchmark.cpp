@@ -0,0 +1,641 @@
+#include "Benchmark.h"
+#include "../ServerHandle.h"
+#include "../primitives/Finders.h"
+#include "../cells/Cell.h"
+#include "../cells/CellKernels.h"
+#include "../primitives/Logger.h"
+#include "../misc/Stopwatch.h"
+#include "../misc/Misc.h"
+
+#include <cmath>
+#include <random>
+#include <map>
+#include <functional>
+
+struct BenchCell : public QuadItem {
+	float size;
+	Boost boost;
+	bool alive;
+	bool drift; // moves at a constant boost.d (players) instead of decaying
+	BenchCell() : QuadItem(0, 0), size(0), boost{ 0, 0, 0 }, alive(false), drift(false) {};
+	BenchCell(const BenchCell& other) : QuadItem(other.x, other.y),
+		size(other.size), boost(other.boost), alive(other.alive), drift(other.drift) {
+		range = other.range;
+	};
+};
+
+struct BenchScene {
+	Rect border;
+	vector<BenchCell> cells;
+};
+
+struct BroadphaseBenchResult {
+	float buildTime = 0;
+	float updateTime = 0;
+	float queryTime = 0;
+	unsigned long hits = 0;
+};
+
+struct NarrowPhaseBenchResult {
+	float time = 0;
+	unsigned long touching = 0;
+	unsigned long inside = 0;
+};
+
+struct FinderBenchResult {
+	float updateTime = 0;
+	float queryTime = 0;
+	unsigned long relocations = 0;
+	unsigned long hits = 0;
+};
+
+static unsigned int argOr(vector<string>& args, unsigned int index, unsigned int fallback) {
+	if (args.size() <= index) return fallback;
+	try {
+		return std::stoul(args[index]);
+	} catch (...) {
+		return fallback;
+	}
+}
+
+static void placeCell(BenchCell& cell, float x, float y, float size) {
+	cell.setX(x);
+	cell.setY(y);
+	cell.size = size;
+	cell.range = { x, y, size, size };
+}
+
+static void bounceCell(BenchCell& cell, Rect& border) {
+	float r = cell.size / 2.0f;
+	float x = cell.getX(), y = cell.getY();
+	if (x <= border.getX() - border.w + r) x = border.getX() - border.w + r, cell.boost.dx = -cell.boost.dx;
+	if (x >= border.getX() + border.w - r) x = border.getX() + border.w - r, cell.boost.dx = -cell.boost.dx;
+	if (y <= border.getY() - border.h + r) y = border.getY() - border.h + r, cell.boost.dy = -cell.boost.dy;
+	if (y >= border.getY() + border.h - r) y = border.getY() + border.h - r, cell.boost.dy = -cell.boost.dy;
+	placeCell(cell, x, y, cell.size);
+}
+
+// Static pellets plus players holding eject macro: every feeder sprays one ejected
+// cell per tick, which flies out with the configured boost. The oldest ejected cells
+// are recycled once the pool is full, like they would get eaten in game.
+static void simulateEjectMacro(ServerHandle* handle, QuadTree& tree, unsigned int pelletCount,
+	unsigned int feederCount, unsigned int ticks, FinderBenchResult& result) {
+
+	std::mt19937 gen(1337);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	Rect border = tree.nodes[0].range;
+	auto randomX = [&]() { return border.getX() - border.w + unit(gen) * 2 * border.w; };
+	auto randomY = [&]() { return border.getY() - border.h + unit(gen) * 2 * border.h; };
+
+	float pelletSize = handle->getSettingFloat("pelletMinSize");
+	float ejectedSize = handle->getSettingFloat("ejectedSize");
+	float ejectedBoost = handle->getSettingFloat("ejectedCellBoost");
+	float dispersion = handle->getSettingFloat("ejectDispersion");
+
+	vector<BenchCell> pellets(pelletCount);
+	vector<BenchCell> feeders(feederCount);
+	vector<BenchCell> ejected(feederCount * 100);
+	vector<Rect> probes;
+
+	for (auto& pellet : pellets) {
+		placeCell(pellet, randomX(), randomY(), pelletSize);
+		tree.insert(&pellet);
+	}
+	for (auto& feeder : feeders) {
+		placeCell(feeder, randomX(), randomY(), 150 + unit(gen) * 350);
+		float angle = unit(gen) * 2 * PI;
+		feeder.boost = { sin(angle), cos(angle), 8 };
+		tree.insert(&feeder);
+	}
+
+	unsigned int nextEjected = 0;
+	Stopwatch stopwatch;
+	for (unsigned int tick = 0; tick < ticks; tick++) {
+		stopwatch.begin();
+
+		for (auto& feeder : feeders) {
+			auto node = feeder.node;
+			placeCell(feeder, feeder.getX() + feeder.boost.dx * feeder.boost.d,
+				feeder.getY() + feeder.boost.dy * feeder.boost.d, feeder.size);
+			bounceCell(feeder, border);
+			tree.update(&feeder);
+			if (feeder.node != node) result.relocations++;
+
+			auto& cell = ejected[nextEjected];
+			nextEjected = (nextEjected + 1) % ejected.size();
+			if (cell.alive) tree.remove(&cell);
+			float angle = atan2(feeder.boost.dx, feeder.boost.dy) + (unit(gen) * 2 - 1) * dispersion;
+			cell.boost = { sin(angle), cos(angle), ejectedBoost };
+			placeCell(cell, feeder.getX() + cell.boost.dx * feeder.size,
+				feeder.getY() + cell.boost.dy * feeder.size, ejectedSize);
+			cell.alive = true;
+			tree.insert(&cell);
+		}
+
+		for (auto& cell : ejected) {
+			if (!cell.alive || cell.boost.d < 1) continue;
+			auto node = cell.node;
+			float d = cell.boost.d / 9;
+			placeCell(cell, cell.getX() + cell.boost.dx * d, cell.getY() + cell.boost.dy * d, cell.size);
+			bounceCell(cell, border);
+			tree.update(&cell);
+			if (cell.node != node) result.relocations++;
+			cell.boost.d -= d;
+		}
+
+		result.updateTime += stopwatch.lap();
+
+		probes.clear();
+		for (auto& feeder : feeders) probes.push_back(feeder.range);
+		for (auto& cell : ejected)
+			if (cell.alive && cell.boost.d >= 1) probes.push_back(cell.range);
+		tree.searchBatch(probes.data(), probes.size(), [&result](unsigned int, QuadItem*) {
+			result.hits++;
+			return false;
+		});
+
+		result.queryTime += stopwatch.lap();
+	}
+}
+
+static void benchFinder(ServerHandle* handle, vector<string>& args) {
+	unsigned int pellets = argOr(args, 1, 20000);
+	unsigned int feeders = argOr(args, 2, 64);
+	unsigned int ticks = argOr(args, 3, 500);
+
+	Rect border(handle->getSettingFloat("worldMapX"), handle->getSettingFloat("worldMapY"),
+		handle->getSettingFloat("worldMapW"), handle->getSettingFloat("worldMapH"));
+	unsigned int maxLevel = handle->getSettingInt("worldFinderMaxLevel");
+	unsigned int maxItems = handle->getSettingInt("worldFinderMaxItems");
+	float looseness = handle->getSettingFloat("worldFinderLooseness");
+	if (looseness <= 1.0f) looseness = 2.0f;
+
+	Logger::info(string_format("Finder benchmark: %u pellets, %u eject macros, %u ticks",
+		pellets, feeders, ticks));
+
+	FinderBenchResult results[2];
+	float loosenesses[2] = { 1.0f, looseness };
+	for (int i = 0; i < 2; i++) {
+		QuadTree tree(border, maxLevel, maxItems);
+		tree.looseness = loosenesses[i];
+		simulateEjectMacro(handle, tree, pellets, feeders, ticks, results[i]);
+		Logger::info(string_format("  looseness %.2f: update %.3fms/tick query %.3fms/tick relocations %.1f/tick nodes %u",
+			loosenesses[i], results[i].updateTime / ticks, results[i].queryTime / ticks,
+			(float) results[i].relocations / ticks, tree.getBranchCount()));
+
+		auto shape = tree.getShape();
+		string depths;
+		for (auto count : shape.depthItems) depths += " " + std::to_string(count);
+		unsigned int queries = tree.counters.queries;
+		unsigned long visited = tree.counters.nodesVisited;
+		Logger::info(string_format("    %.1f items/leaf (max %u) %.1f nodes/query splits %.1f/tick merges %.1f/tick items by depth:%s",
+			shape.itemsPerLeaf(), shape.maxLeafItems, queries ? (float) visited / queries : 0.0f,
+			(float) tree.counters.splits / ticks, (float) tree.counters.merges / ticks, depths.c_str()));
+	}
+
+	if (results[0].hits != results[1].hits)
+		Logger::warn(string_format("Loose tree query results differ: %lu vs %lu hits", results[0].hits, results[1].hits));
+}
+
+// Copies the cells of the first running world, so every backend replays the same state
+static bool recordScene(ServerHandle* handle, BenchScene& scene) {
+	if (!handle->worlds.size()) return false;
+	auto world = handle->worlds.begin()->second;
+	if (!world->cells.size()) return false;
+
+	std::mt19937 gen(1337);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	scene.border = world->border;
+	scene.cells.resize(world->cells.size());
+	unsigned int i = 0;
+	for (auto c : world->cells) {
+		auto& cell = scene.cells[i++];
+		placeCell(cell, c->getX(), c->getY(), c->getSize());
+		cell.alive = c->getType() != PELLET;
+		cell.boost = c->boost;
+		if (c->getType() == PLAYER && !c->isBoosting()) {
+			float angle = unit(gen) * 2 * PI;
+			cell.boost = { sin(angle), cos(angle), 10 };
+			cell.drift = true;
+		}
+	}
+	return true;
+}
+
+// Fallback when no world is running: pellets plus players of every size
+static void generateScene(ServerHandle* handle, BenchScene& scene, unsigned int pelletCount, unsigned int playerCount) {
+	std::mt19937 gen(1337);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	scene.border = Rect(handle->getSettingFloat("worldMapX"), handle->getSettingFloat("worldMapY"),
+		handle->getSettingFloat("worldMapW"), handle->getSettingFloat("worldMapH"));
+	auto& border = scene.border;
+	float pelletSize = handle->getSettingFloat("pelletMinSize");
+	float minSize = handle->getSettingFloat("playerMinSize");
+
+	scene.cells.resize(pelletCount + playerCount);
+	for (unsigned int i = 0; i < scene.cells.size(); i++) {
+		auto& cell = scene.cells[i];
+		float x = border.getX() - border.w + unit(gen) * 2 * border.w;
+		float y = border.getY() - border.h + unit(gen) * 2 * border.h;
+		if (i < pelletCount) {
+			placeCell(cell, x, y, pelletSize);
+			continue;
+		}
+		// Mostly small split cells, with a long tail of big ones
+		placeCell(cell, x, y, minSize + pow(unit(gen), 4) * 1000);
+		float angle = unit(gen) * 2 * PI;
+		cell.boost = { sin(angle), cos(angle), 10 };
+		cell.alive = true;
+		cell.drift = true;
+	}
+}
+
+// Replays the scene on a copy: movers follow their boost, then every mover probes the finder
+template<typename T>
+static void replayScene(T& finder, const BenchScene& recorded, unsigned int ticks, BroadphaseBenchResult& result) {
+	BenchScene scene = recorded;
+	vector<Rect> probes;
+	Stopwatch stopwatch;
+
+	stopwatch.begin();
+	for (auto& cell : scene.cells) finder.insert(&cell);
+	result.buildTime = stopwatch.lap();
+
+	for (unsigned int tick = 0; tick < ticks; tick++) {
+		stopwatch.lap();
+		for (auto& cell : scene.cells) {
+			if (!cell.alive || cell.boost.d < 1) continue;
+			float d = cell.drift ? cell.boost.d : cell.boost.d / 9;
+			placeCell(cell, cell.getX() + cell.boost.dx * d, cell.getY() + cell.boost.dy * d, cell.size);
+			bounceCell(cell, scene.border);
+			finder.update(&cell);
+			if (!cell.drift) cell.boost.d -= d;
+		}
+		result.updateTime += stopwatch.lap();
+
+		probes.clear();
+		for (auto& cell : scene.cells)
+			if (cell.alive) probes.push_back(cell.range);
+		finder.searchBatch(probes.data(), probes.size(), [&result](unsigned int, QuadItem*) {
+			result.hits++;
+			return false;
+		});
+		result.queryTime += stopwatch.lap();
+	}
+}
+
+static void benchBroadphase(ServerHandle* handle, vector<string>& args) {
+	unsigned int ticks = argOr(args, 1, 200);
+	// Replays the running world unless a synthetic scene size is given
+	BenchScene scene;
+	if (args.size() <= 2 && recordScene(handle, scene)) {
+		Logger::info(string_format("Broad phase benchmark: recorded %u cells from the running world, %u ticks",
+			(unsigned int) scene.cells.size(), ticks));
+	} else {
+		unsigned int pellets = argOr(args, 2, 20000);
+		unsigned int players = argOr(args, 3, 1000);
+		generateScene(handle, scene, pellets, players);
+		Logger::info(string_format("Broad phase benchmark: generated %u pellets and %u player cells, %u ticks",
+			pellets, players, ticks));
+	}
+
+	unsigned int maxLevel = handle->getSettingInt("worldFinderMaxLevel");
+	unsigned int maxItems = handle->getSettingInt("worldFinderMaxItems");
+	float looseness = std::max(handle->getSettingFloat("worldFinderLooseness"), 1.0f);
+	float cellSize = handle->getSettingFloat("worldFinderCellSize");
+
+	BroadphaseBenchResult results[3];
+	{
+		QuadTree tree(scene.border, maxLevel, maxItems);
+		tree.looseness = looseness;
+		replayScene(tree, scene, ticks, results[0]);
+	}
+	{
+		HashGrid grid(scene.border, cellSize);
+		replayScene(grid, scene, ticks, results[1]);
+	}
+	{
+		SweepAndPrune sweep;
+		replayScene(sweep, scene, ticks, results[2]);
+	}
+
+	const char* names[3] = { "quadtree", "grid", "sweep" };
+	for (int i = 0; i < 3; i++) {
+		Logger::info(string_format("  %-8s build %.3fms update %.3fms/tick query %.3fms/tick total %.3fms/tick",
+			names[i], results[i].buildTime, results[i].updateTime / ticks, results[i].queryTime / ticks,
+			(results[i].updateTime + results[i].queryTime) / ticks));
+		if (results[i].hits != results[0].hits)
+			Logger::warn(string_format("  %s query results differ from quadtree: %lu vs %lu hits",
+				names[i], results[i].hits, results[0].hits));
+	}
+}
+
+// Player cells of every size heading for targets far past the border, so they keep moving
+// for the whole run. Every tenth cell is linelocked and a few have no owner.
+static void generatePlayerBatch(ServerHandle* handle, PlayerCellBatch& batch, PlayerCellParams& params, unsigned int count) {
+	std::mt19937 gen(1337);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	Rect border(handle->getSettingFloat("worldMapX"), handle->getSettingFloat("worldMapY"),
+		handle->getSettingFloat("worldMapW"), handle->getSettingFloat("worldMapH"));
+	float minSize = handle->getSettingFloat("playerMinSize");
+	float maxSize = handle->getSettingFloat("playerMaxSize");
+
+	params.moveMult = handle->getSettingFloat("playerMoveMult");
+	params.stepMult = 1;
+	params.decayMult = handle->getSettingFloat("playerDecayMult");
+	params.minSize = minSize;
+	params.splitSquareSize = maxSize * maxSize;
+	params.left = border.getX() - border.w;
+	params.right = border.getX() + border.w;
+	params.bottom = border.getY() - border.h;
+	params.top = border.getY() + border.h;
+
+	batch.resize(count);
+	for (unsigned int i = 0; i < count; i++) {
+		batch.x[i] = border.getX() - border.w + unit(gen) * 2 * border.w;
+		batch.y[i] = border.getY() - border.h + unit(gen) * 2 * border.h;
+		batch.size[i] = minSize + pow(unit(gen), 4) * maxSize * 1.2f;
+		float angle = unit(gen) * 2 * PI;
+		batch.targetX[i] = batch.x[i] + sin(angle) * 100000;
+		batch.targetY[i] = batch.y[i] + cos(angle) * 100000;
+		batch.flags[i] = unit(gen) < 0.05f ? 0 : PLAYER_OWNED | PLAYER_MOVES;
+		if (i % 10 || !batch.flags[i]) continue;
+		batch.flags[i] |= PLAYER_LOCKED;
+		batch.lineA[i] = cos(angle);
+		batch.lineB[i] = -sin(angle);
+		batch.lineC[i] = -(batch.lineA[i] * batch.x[i] + batch.lineB[i] * batch.y[i]);
+		batch.lineInv[i] = 1 / (batch.lineA[i] * batch.lineA[i] + batch.lineB[i] * batch.lineB[i]);
+	}
+}
+
+// Largest difference to the scalar path, relative to the value and at least 1
+static float kernelError(const PlayerCellBatch& a, const PlayerCellBatch& b) {
+	float error = 0;
+	auto compare = [&error](float x, float y) {
+		error = std::max(error, std::abs(x - y) / std::max(1.0f, std::abs(x)));
+	};
+	for (unsigned int i = 0; i < a.count; i++) {
+		compare(a.x[i], b.x[i]);
+		compare(a.y[i], b.y[i]);
+		compare(a.size[i], b.size[i]);
+	}
+	return error;
+}
+
+static void benchKernels(ServerHandle* handle, vector<string>& args) {
+	unsigned int count = std::max(argOr(args, 1, 10000), 1U);
+	unsigned int rounds = std::max(argOr(args, 2, 1000), 1U);
+	auto supported = detectKernelLevel();
+	Logger::info(string_format("Player cell kernel benchmark: %u cells, %u rounds, this cpu runs up to %s",
+		count, rounds, kernelLevelName(supported)));
+
+	PlayerCellBatch start;
+	PlayerCellParams params;
+	generatePlayerBatch(handle, start, params, count);
+
+	// Every level takes one step from the same start and is checked against the scalar path,
+	// then is timed from there on
+	PlayerCellBatch reference = start;
+	integratePlayerCells(reference, params, 0, reference.padded(), KernelLevel::SCALAR);
+	float scalarTime = 0;
+	Stopwatch stopwatch;
+	for (int level = (int) KernelLevel::SCALAR; level <= (int) supported; level++) {
+		PlayerCellBatch batch = start;
+		integratePlayerCells(batch, params, 0, batch.padded(), (KernelLevel) level);
+		float error = kernelError(reference, batch);
+
+		stopwatch.begin();
+		for (unsigned int round = 0; round < rounds; round++)
+			integratePlayerCells(batch, params, 0, batch.padded(), (KernelLevel) level);
+		float time = stopwatch.elapsed();
+		if (level == (int) KernelLevel::SCALAR) scalarTime = time;
+
+		Logger::info(string_format("  %-7s %.4fms per 10k cells, %.1fM cells/s, %.2fx scalar, max relative error %.2g",
+			kernelLevelName((KernelLevel) level), time / rounds * 10000 / count,
+			(float) count * rounds / time / 1000, scalarTime / time, error));
+		if (error > 1e-5f)
+			Logger::warn(string_format("  %s results differ from the scalar path beyond float tolerance",
+				kernelLevelName((KernelLevel) level)));
+	}
+}
+
+// Inside counts of one probe against one candidate, the way the collision pass marks them
+static void countContact(NarrowPhaseBenchResult& result, unsigned char flags) {
+	if (!(flags & CONTACT_TOUCH)) return;
+	result.touching++;
+	if (flags & (CONTACT_PROBE_INSIDE | CONTACT_OTHER_INSIDE)) result.inside++;
+}
+
+// Runs the narrow phase over the candidates search hands out for chunks of probes, per item the
+// way the collision callback used to or batched at the given level. Batches are tested whenever
+// they fill up and at the end of every chunk, the kernel alone is timed as well.
+template<typename S>
+static void runNarrowPhase(vector<BenchCell*>& probes, S&& search, unsigned int rounds, bool batched, KernelLevel level,
+	NarrowPhaseBenchResult& result, float& kernelTime) {
+	const unsigned int chunk = 256;
+	ContactBatch batch;
+	Stopwatch stopwatch, kernelWatch;
+	auto test = [&batch, &result, &kernelTime, &kernelWatch, level]() {
+		unsigned int padded = batch.pad();
+		kernelWatch.begin();
+		testContacts(batch, 0, padded, level);
+		kernelTime += kernelWatch.elapsed();
+		for (unsigned int i = 0; i < batch.count; i++) countContact(result, batch.flags[i]);
+		batch.clear();
+	};
+
+	kernelTime = 0;
+	stopwatch.begin();
+	for (unsigned int round = 0; round < rounds; round++) {
+		result.touching = result.inside = 0;
+		for (unsigned int begin = 0; begin < probes.size(); begin += chunk) {
+			unsigned int end = std::min(begin + chunk, (unsigned int) probes.size());
+			if (!batched) {
+				search(begin, end, [&probes, begin, &result](unsigned int index, QuadItem* o) {
+					auto c = probes[begin + index];
+					auto other = (BenchCell*) o;
+					if (c == other) return false;
+					float dx = c->getX() - other->getX();
+					float dy = c->getY() - other->getY();
+					float dSq = dx * dx + dy * dy;
+					float reach = c->size + other->size;
+					if (dSq >= reach * reach) return false;
+					result.touching++;
+					if (c->size > other->size ? dSq < c->size : dSq < other->size) result.inside++;
+					return false;
+				});
+				continue;
+			}
+			search(begin, end, [&probes, begin, &batch, &test](unsigned int index, QuadItem* o) {
+				auto c = probes[begin + index];
+				auto other = (BenchCell*) o;
+				if (c == other) return false;
+				if (batch.full()) test();
+				batch.add(c->getX(), c->getY(), c->size, other->getX(), other->getY(), other->size);
+				return false;
+			});
+			test();
+		}
+	}
+	result.time = stopwatch.elapsed();
+}
+
+static void benchNarrowPhase(ServerHandle* handle, vector<string>& args) {
+	unsigned int rounds = std::max(argOr(args, 1, 20), 1U);
+	BenchScene scene;
+	if (args.size() <= 2 && recordScene(handle, scene)) {
+		Logger::info(string_format("Narrow phase benchmark: recorded %u cells from the running world, %u rounds",
+			(unsigned int) scene.cells.size(), rounds));
+	} else {
+		unsigned int pellets = argOr(args, 2, 20000);
+		unsigned int players = argOr(args, 3, 1000);
+		generateScene(handle, scene, pellets, players);
+		Logger::info(string_format("Narrow phase benchmark: generated %u pellets and %u player cells, %u rounds",
+			pellets, players, rounds));
+	}
+
+	QuadTree tree(scene.border, handle->getSettingInt("worldFinderMaxLevel"), handle->getSettingInt("worldFinderMaxItems"));
+	tree.looseness = std::max(handle->getSettingFloat("worldFinderLooseness"), 1.0f);
+	vector<BenchCell*> probes;
+	vector<CircleBorder> circles;
+	vector<Rect> squares;
+	for (auto& cell : scene.cells) {
+		tree.insert(&cell);
+		if (!cell.alive) continue;
+		probes.push_back(&cell);
+		circles.push_back(CircleBorder(cell.getX(), cell.getY(), cell.size));
+		squares.push_back(cell.range);
+	}
+
+	// Circle searches hand out touching pairs only, like the tree path of the collision pass.
+	// Bounding squares also hand out near misses, like the neighbour lists of the Verlet path.
+	auto supported = detectKernelLevel();
+	for (int exact = 1; exact >= 0; exact--) {
+		auto search = [&tree, &circles, &squares, exact](unsigned int begin, unsigned int end, auto&& callback) {
+			if (exact) tree.searchBatch(circles.data() + begin, end - begin, callback);
+			else tree.searchBatch(squares.data() + begin, end - begin, callback);
+		};
+		NarrowPhaseBenchResult reference;
+		float kernelTime = 0;
+		runNarrowPhase(probes, search, rounds, false, KernelLevel::SCALAR, reference, kernelTime);
+		Logger::info(string_format("  %s candidates, per item %.3fms/round, %lu touching pairs, %lu inside",
+			exact ? "circle" : "square", reference.time / rounds, reference.touching, reference.inside));
+
+		for (int level = (int) KernelLevel::SCALAR; level <= (int) supported; level++) {
+			NarrowPhaseBenchResult result;
+			runNarrowPhase(probes, search, rounds, true, (KernelLevel) level, result, kernelTime);
+			Logger::info(string_format("    %-7s %.3fms/round, %.2fx per item, kernel %.3fms/round",
+				kernelLevelName((KernelLevel) level), result.time / rounds, reference.time / result.time, kernelTime / rounds));
+			if (result.touching != reference.touching || result.inside != reference.inside)
+				Logger::warn(string_format("    %s contacts differ from the per item test: %lu/%lu vs %lu/%lu",
+					kernelLevelName((KernelLevel) level), result.touching, result.inside, reference.touching, reference.inside));
+		}
+	}
+}
+
+// One player split into count cells bunched up around its center, the way they pile up
+// while moving towards the mouse
+static void generatePlayerGroup(ServerHandle* handle, vector<BenchCell>& cells, unsigned int count) {
+	std::mt19937 gen(1337);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	float minSize = handle->getSettingFloat("playerMinSize");
+	cells.resize(count);
+	float squareSizes = 0;
+	for (auto& cell : cells) {
+		cell.size = minSize + pow(unit(gen), 2) * 200;
+		squareSizes += cell.size * cell.size;
+	}
+	float radius = sqrt(squareSizes) * 1.2f;
+	for (auto& cell : cells) {
+		float angle = unit(gen) * 2 * PI;
+		float distance = sqrt(unit(gen)) * radius;
+		placeCell(cell, sin(angle) * distance, cos(angle) * distance, cell.size);
+		cell.alive = true;
+	}
+}
+
+// A player's own pairs found both ways: through the finder like the probe pass used to, each
+// pair taken by one side and tested in contact batches, and by the sweep solvePlayerGroups
+// runs over the player's cells
+static void benchPlayerGroup(ServerHandle* handle, vector<string>& args) {
+	unsigned int count = std::max(argOr(args, 1, 256), 2U);
+	unsigned int rounds = std::max(argOr(args, 2, 1000), 1U);
+	Logger::info(string_format("Player group benchmark: one player with %u cells, %u rounds", count, rounds));
+
+	vector<BenchCell> cells;
+	generatePlayerGroup(handle, cells, count);
+	Rect border(handle->getSettingFloat("worldMapX"), handle->getSettingFloat("worldMapY"),
+		handle->getSettingFloat("worldMapW"), handle->getSettingFloat("worldMapH"));
+	QuadTree tree(border, handle->getSettingInt("worldFinderMaxLevel"), handle->getSettingInt("worldFinderMaxItems"));
+	tree.looseness = std::max(handle->getSettingFloat("worldFinderLooseness"), 1.0f);
+	vector<BenchCell*> probes;
+	vector<CircleBorder> circles;
+	for (auto& cell : cells) {
+		tree.insert(&cell);
+		probes.push_back(&cell);
+		circles.push_back(CircleBorder(cell.getX(), cell.getY(), cell.size));
+	}
+
+	Stopwatch stopwatch;
+	unsigned long finderPairs = 0;
+	ContactBatch batch;
+	auto test = [&batch, &finderPairs]() {
+		testContacts(batch, 0, batch.pad());
+		for (unsigned int i = 0; i < batch.count; i++)
+			if (batch.flags[i] & CONTACT_TOUCH) finderPairs++;
+		batch.clear();
+	};
+	stopwatch.begin();
+	for (unsigned int round = 0; round < rounds; round++) {
+		finderPairs = 0;
+		tree.searchBatch(circles.data(), circles.size(), [&probes, &batch, &test](unsigned int index, QuadItem* o) {
+			auto c = probes[index];
+			auto other = (BenchCell*) o;
+			if (other <= c) return false;
+			if (batch.full()) test();
+			batch.add(c->getX(), c->getY(), c->size, other->getX(), other->getY(), other->size);
+			return false;
+		});
+		test();
+	}
+	float finderTime = stopwatch.elapsed();
+
+	CellGroup group;
+	vector<GroupContact> contacts;
+	stopwatch.begin();
+	for (unsigned int round = 0; round < rounds; round++) {
+		group.resize(count);
+		for (unsigned int i = 0; i < count; i++) {
+			group.x[i] = cells[i].getX();
+			group.y[i] = cells[i].getY();
+			group.size[i] = cells[i].size;
+		}
+		findGroupContacts(group, contacts);
+	}
+	float sweepTime = stopwatch.elapsed();
+
+	Logger::info(string_format("  finder %.4fms/round, %lu touching pairs", finderTime / rounds, finderPairs));
+	Logger::info(string_format("  sweep  %.4fms/round, %u touching pairs, %.2fx finder",
+		sweepTime / rounds, (unsigned int) contacts.size(), finderTime / sweepTime));
+	if (finderPairs != contacts.size())
+		Logger::warn(string_format("  sweep pairs differ from the finder: %u vs %lu", (unsigned int) contacts.size(), finderPairs));
+}
+
+void runBenchmark(ServerHandle* handle, vector<string>& args) {
+	static const std::map<string, std::function<void(ServerHandle*, vector<string>&)>> suites = {
+		{ "finder", benchFinder },
+		{ "broadphase", benchBroadphase },
+		{ "kernels", benchKernels },
+		{ "narrowphase", benchNarrowPhase },
+		{ "playergroup", benchPlayerGroup }
+	};
+
+	auto suite = args.size() ? suites.find(args[0]) : suites.cend();
+	if (suite == suites.cend()) {
+		string names;
+		for (auto& [name, _] : suites) names += " " + name;
+		Logger::warn("Usage: benchmark <suite> [args], suites:" + names);
+		return;
+	}
+	suite->second(handle, args);
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+class ServerHandle;
+
+// Offline benchmark suites, run from the cli with "benchmark <suite> [args]".
+// They run on the tick thread, so the server stalls until a suite finishes.
+void runBenchmark(ServerHandle* handle, vector<string>& args);
@@ -14,16 +14,11 @@ PlayerBot::PlayerBot(World* world) : Router(&world->handle->listener) {
 	onDead();
 };
 
-unsigned int virusInRange(list<Cell*>& viruses, Cell* cell, float feedMass) {
-	float radiusSquared = (cell->getMass() + feedMass) * 100;
-	unsigned int count = 0;
-	for (auto virus : viruses) {
-		float dx = virus->getX() - cell->getX();
-		float dy = virus->getY() - cell->getY();
-		float dSquared = dx * dx + dy * dy;
-		if (dSquared < radiusSquared) count++;
-	}
-	return count;
+// Viruses and mother cells close enough to pop cell once fed, counting stops at 2
+unsigned int virusInRange(World* world, Cell* cell, float feedMass) {
+	float radius = sqrt((cell->getMass() + feedMass) * 100);
+	return world->finder->nearest(*cell, radius, 2, cellTypeMask(VIRUS) | cellTypeMask(MOTHER_CELL),
+		[](QuadItem*) { return true; });
 }
 
 void PlayerBot::update() {
@@ -31,7 +26,7 @@ void PlayerBot::update() {
 		lockTicks = 5;
 	}
 	if (splitCooldownTicks > 0) splitCooldownTicks--;
-	else target = nullptr;
+	else target = NULL_HANDLE;
 
 	if (lockTicks > 0) {
 		lockTicks--;
@@ -50,11 +45,12 @@ void PlayerBot::update() {
 	if (!biggestCell) return;
 
 	if (target) {
-		if (!target->exist || !canEat(biggestCell->getSize(), target->getSize()))
-			target = nullptr;
+		auto cell = player->world->getCell(target);
+		if (!cell || !canEat(biggestCell->getSize(), cell->getSize()))
+			target = NULL_HANDLE;
 		else {
-			mouseX = target->getX();
-			mouseY = target->getY();
+			mouseX = cell->getX();
+			mouseY = cell->getY();
 			return;
 		}
 	}
@@ -88,12 +84,20 @@ void PlayerBot::update() {
 	Cell* virusToSplitOn = nullptr;
 	Cell* popsplitTarget = nullptr;
 	Cell* solotrickTarget = nullptr;
-	list<Cell*> viruses;
 
-	if (trypopsplit)
-		for (auto [_, check] : player->visibleCells)
-			if (check->getType() == CellType::VIRUS || check->getType() == CellType::MOTHER_CELL)
-				viruses.push_back(check);
+	// Largest enemy cell within reach that has exactly one virus next to it
+	if (trypopsplit) {
+		float feedMass = biggestCell->getMass() * 0.75f;
+		player->world->finder->largest(*biggestCell, biggestCell->getSize() * 1.25f, 1, cellTypeMask(PLAYER),
+			[this, feedMass, &popsplitTarget](QuadItem* item) {
+			auto check = (Cell*) item;
+			if (!check->owner || check->owner == player) return false;
+			if (player->team > 0 && player->team == check->owner->team) return false;
+			if (virusInRange(player->world, check, feedMass) != 1) return false;
+			popsplitTarget = check;
+			return true;
+		});
+	}
 
 	for (auto [_, check] : player->visibleCells) {
 		float dx = check->getX() - biggestCell->getX();
@@ -105,12 +109,6 @@ void PlayerBot::update() {
 			case CellType::PLAYER:
 				if (!check->owner || check->owner == player) break;
 				if (player->team > 0 && player->team == check->owner->team) break;
-				if (trypopsplit) {
-					auto count = virusInRange(viruses, check, biggestCell->getMass() * 0.75f);
-					if (count == 1)
-						if (splitDist < biggestCell->getSize() * 1.25f && (!popsplitTarget || check->getSize() > popsplitTarget->getSize()))
-							popsplitTarget = check;
-				}
 				if (canEat(biggestCell->getSize(), check->getSize())) {
 					influence = truncatedInfluence;
 					if (!canSplitKill(biggestCell->getSize(), check->getSize(), splitDist)) break;
@@ -195,7 +193,7 @@ void PlayerBot::update() {
 		splitCooldownTicks <= 0 && bestPrey && 
 		bestPrey->getSize() < 0.85f * biggestCell->getSize() &&
 		bestPrey->getSize() > 0.7f * biggestCell->getSize()) {
-		target = bestPrey;
+		target = bestPrey->handle;
 		mouseX = bestPrey->getX();
 		mouseY = bestPrey->getY();
 		splitAttempts = 10;
@@ -205,7 +203,7 @@ void PlayerBot::update() {
 
 	if (willingToSplit && !splitkillObstacleNearby && splitCooldownTicks <= 0 &&
 		bestPrey && bestPrey->getSize() * 3.0f > biggestCell->getSize()) {
-		target = bestPrey;
+		target = bestPrey->handle;
 		mouseX = bestPrey->getX();
 		mouseY = bestPrey->getY();
 		splitAttempts++;
@@ -8,7 +8,7 @@ class PlayerBot : public Router {
 public:
 	unsigned int splitCooldownTicks = 0;
 	unsigned int lockTicks = 0;
-	Cell* target = nullptr;
+	CellHandle target = NULL_HANDLE;
 	bool selfeed = false;
 	bool trypopsplit = false;
 	bool revpopsplit = false;
@@ -2,52 +2,26 @@
 #include "../worlds/World.h"
 #include "../ServerHandle.h"
 
-Cell::Cell(World* world, float x, float y, float size, unsigned int color) : 
+Cell::Cell(World* world, CellType type, float x, float y, float size, unsigned int color) : 
 	QuadItem(x, y), world(world), id(world->getNextCellId()), birthTick(world->handle->tick),
-	size(size), color(color) {};
+	size(size), color(color), type(type) {};
 
 unsigned long Cell::getAge() { return (world->handle->tick - birthTick) * world->handle->stepMult; };
 
 CellData* Cell::getData() {
 	data = new CellData(x, y, getType(), id, owner ? owner->id : 0, 
-		getAge(), eatenBy ? eatenBy->id : 0, size, owner ? 0 : 1);
+		getAge(), eatenById, size, owner ? 0 : 1);
 	return data;
 }
 
 PlayerCell::PlayerCell(World* world, Player* owner, float x, float y, float size):
-	Cell (world, x, y, size, owner ? owner->cellColor : 0) {
+	Cell (world, PLAYER, x, y, size, owner ? owner->cellColor : 0) {
 	this->owner = owner;
 };
 
 string_view PlayerCell::getName() { return owner->cellName; };
 string_view PlayerCell::getSkin() { return owner->cellSkin; };
 
-EatResult PlayerCell::getEatResult(Cell* other) {
-	if (other->getType() == PLAYER) {
-		if (!owner && !other->owner) return EatResult::COLLIDE;
-		if (!owner) return EatResult::NONE;
-		auto delay = world->handle->runtime.playerNoCollideDelay;
-		if (owner && other->owner && other->owner->id == owner->id) {
-			if (other->getAge() < delay || getAge() < delay) return EatResult::NONE;
-			if (canMerge() && ((PlayerCell*)other)->canMerge()) return EatResult::EAT;
-			return EatResult::COLLIDE;
-		}
-		if (owner && other->owner && owner->team >= 0 && other->owner->team == owner->team)
-			return (other->getAge() < delay || getAge() < delay) ? EatResult::NONE : EatResult::COLLIDE;
-		return getDefaultEatResult(other);
-	}
-	if (!owner) return EatResult::NONE;
-	if (other->getType() == MOTHER_CELL &&
-		other->getSize() > size* world->handle->runtime.worldEatMult) return EatResult::EATINVD;
-	if (other->getType() == PELLET) return EatResult::EAT;
-	return getDefaultEatResult(other);
-}
-
-EatResult PlayerCell::getDefaultEatResult(Cell* other) {
-	if (world->handle->tick - owner->joinTick < world->handle->runtime.spawnProtection && other->owner != owner) return EatResult::NONE;
-	return other->getSize() * world->handle->runtime.worldEatMult > size ? EatResult::NONE : EatResult::EAT;
-}
-
 void PlayerCell::onTick() {
 	Cell::onTickDefault();
 	if (!owner) {
@@ -57,7 +31,7 @@ void PlayerCell::onTick() {
 	}
 	if (color != owner->cellColor) {
 		color = owner->cellColor;
-		colorChanged = true;
+		cellFlags |= COLOR_CHANGED_BIT;
 	}
 	auto delay = world->handle->runtime.playerNoMergeDelay;
 	if (world->handle->runtime.playerMergeTime > 0) {
@@ -84,25 +58,16 @@ void PlayerCell::onRemoved() {
 	}
 
 	owner->ownedCells.remove(this);
-	if (!owner->ownedCells.size() && eatenBy && eatenBy->owner)
-		eatenBy->owner->killCount++;
+	if (!owner->ownedCells.size()) {
+		auto eater = world->getCell(eatenBy);
+		if (eater && eater->owner) eater->owner->killCount++;
+	}
 
 	owner->updateState(PlayerState::DEAD);
 }
 
 Virus::Virus(World* world, float x, float y) :
-	Cell(world, x, y, world->handle->runtime.virusSize, 0x33FF33) {};
-
-EatResult Virus::getEatResult(Cell* other) {
-	if (other->getType() == EJECTED_CELL) return getEjectedEatResult(true);
-	if (other->getType() == MOTHER_CELL) return EatResult::EATINVD;
-	return EatResult::NONE;
-}
-
-EatResult Virus::getEjectedEatResult(bool isSelf) {
-	return world->virusCount >= world->handle->runtime.virusMaxCount ?
-		EatResult::NONE : isSelf ? EatResult::EAT : EatResult::EATINVD;
-}
+	Cell(world, VIRUS, x, y, world->handle->runtime.virusSize, 0x33FF33) {};
 
 void Virus::whenAte(Cell* cell) {
 	auto runtime = &world->handle->runtime;
@@ -136,17 +101,10 @@ void Virus::onRemoved() {
 }
 
 EjectedCell::EjectedCell(World* world, Player* owner, float x, float y, unsigned int color) :
-	Cell(world, x, y, world->handle->runtime.ejectedSize, color) {
+	Cell(world, EJECTED_CELL, x, y, world->handle->runtime.ejectedSize, color) {
 	this->owner = owner;
 };
 
-EatResult EjectedCell::getEatResult(Cell* other) {
-	if (other->getType() == VIRUS) return ((Virus*)other)->getEjectedEatResult(false);
-	if (other->getType() == MOTHER_CELL) return EatResult::EATINVD;
-	if (other->getType() == EJECTED_CELL) return EatResult::COLLIDE;
-	return EatResult::NONE;
-}
-
 void EjectedCell::onSpawned() {
 }
 
@@ -154,20 +112,12 @@ void EjectedCell::onRemoved() {
 }
 
 Pellet::Pellet(World* world, Spawner* spawner, float x, float y):
-	Cell(world, x, y, world->handle->runtime.pelletMinSize, randomColor()),
-	spawner(spawner), lastGrowTick(birthTick) {};
-
-void Pellet::onTick() {
-	Cell::onTickDefault();
-	if (size >= world->handle->runtime.pelletMaxSize) return;
-	if (world->handle->tick - lastGrowTick > world->handle->runtime.pelletGrowTicks / world->handle->stepMult) {
-		lastGrowTick = world->handle->tick;
-		setMass(getMass() + 1);
-	}
-}
+	Cell(world, PELLET, x, y, world->handle->runtime.pelletMinSize, randomColor()),
+	spawner(spawner) {};
 
 void Pellet::onSpawned() {
 	world->pelletCount++;
+	world->addGrowingPellet(this);
 }
 
 void Pellet::onRemoved() {
@@ -175,7 +125,7 @@ void Pellet::onRemoved() {
 }
 
 MotherCell::MotherCell(World* world, float x, float y) :
-	Cell(world, x, y, world->handle->runtime.mothercellSize, 0xCE6363) {};
+	Cell(world, MOTHER_CELL, x, y, world->handle->runtime.mothercellSize, 0xCE6363) {};
 
 void MotherCell::onTick() {
 	auto runtime = &world->handle->runtime;
@@ -205,7 +155,7 @@ void MotherCell::spawnPellet() {
 	auto angle = ((float)rand() / (RAND_MAX)) * 2 * PI;
 	auto x = this->x + size * sin(angle);
 	auto y = this->y + size * cos(angle);
-	auto pellet = new Pellet(world, this, x, y);
+	auto pellet = world->pools.pellets.create(world, static_cast<Spawner*>(this), x, y);
 	pellet->boost.dx = sin(angle);
 	pellet->boost.dy = cos(angle);
 	auto d = world->handle->runtime.mothercellPelletBoost;
@@ -16,10 +16,22 @@ static const float PI = atan(1) * 4;
 // Linelock and cell update flags
 const unsigned char LOCK_BIT = 0x01;
 const unsigned char UPDATE_BIT = 0x02; // As seen in example, might be useful
+// What changed since the last tick, sent to clients and cleared by onTickDefault
+const unsigned char POS_CHANGED_BIT   = 0x04;
+const unsigned char SIZE_CHANGED_BIT  = 0x08;
+const unsigned char COLOR_CHANGED_BIT = 0x10;
+const unsigned char NAME_CHANGED_BIT  = 0x20;
+const unsigned char SKIN_CHANGED_BIT  = 0x40;
+const unsigned char CHANGED_BITS = POS_CHANGED_BIT | SIZE_CHANGED_BIT | COLOR_CHANGED_BIT | NAME_CHANGED_BIT | SKIN_CHANGED_BIT;
 
 class World;
 class Player;
 
+// Type, slot and generation of a cell in its world's CellPools, see CellPool.h. Stops resolving
+// once the cell is removed, 0 never resolves.
+typedef unsigned int CellHandle;
+const CellHandle NULL_HANDLE = 0;
+
 enum CellType : unsigned char {
 	PLAYER,
 	PELLET,
@@ -28,6 +40,11 @@ enum CellType : unsigned char {
 	MOTHER_CELL
 };
 
+// CellType bits for filtered finder queries, cells are inserted with kind = getType()
+constexpr unsigned char cellTypeMask(CellType type) { return 1 << type; }
+const unsigned char SPAWN_AVOID_MASK = (1 << PLAYER) | (1 << VIRUS) | (1 << MOTHER_CELL);
+const unsigned char SPIKED_MASK = (1 << VIRUS) | (1 << MOTHER_CELL);
+
 enum class EatResult : unsigned char {
 	NONE,
 	COLLIDE,
@@ -55,6 +72,7 @@ class Cell : public QuadItem {
 protected:
 	unsigned int color;
 	float size;
+	CellType type;
 public:
 
 	unsigned char cellFlags = 0; // Added for linelock and other states
@@ -65,32 +83,38 @@ public:
 	unsigned long birthTick;
 	unsigned long deadTick = 0;
 	bool inside = false;
+	bool probe = false; // queries the finder in this tick's collision pass
+	// Collision candidates and where the cell stood when they were taken, see World::refreshNeighbours
+	std::vector<Cell*> neighbours;
+	float anchorX = 0;
+	float anchorY = 0;
+	float anchorSize = 0;
+	bool anchored = false;
+	unsigned long listTick = 0;
+	unsigned long probedTick = 0;
 	bool exist = true;
+	unsigned int index = 0; // slot in World::cells while it is listed there
+	CellHandle handle = NULL_HANDLE; // set by the pool that made the cell
 
-	Cell* eatenBy = nullptr;
+	CellHandle eatenBy = NULL_HANDLE;
+	unsigned int eatenById = 0; // id of the eater when it ate, sent to clients
 	Boost boost = Boost();
 
 	Player* owner = nullptr;
 
-	bool posChanged   = false;
-	bool sizeChanged  = false;
-	bool colorChanged = false;
-	bool nameChanged  = false;
-	bool skinChanged  = false;
-
-	Cell(World* world, float x, float y, float size, unsigned int color);
+	Cell(World* world, CellType type, float x, float y, float size, unsigned int color);
 
 	void setX(float x) {
 		if (x != this->x) {
 			this->x = x;
-			posChanged = true;
+			cellFlags |= POS_CHANGED_BIT;
 		}
 	}
 
 	void setY(float y) {
 		if (y != this->y) {
 			this->y = y;
-			posChanged = true;
+			cellFlags |= POS_CHANGED_BIT;
 		}
 	}
 
@@ -98,7 +122,7 @@ public:
 	void setSize(float size) {
 		if (size != this->size) {
 			this->size = size;
-			sizeChanged = true;
+			cellFlags |= SIZE_CHANGED_BIT;
 		}
 	}
 
@@ -109,21 +133,23 @@ public:
 	void setColor(unsigned int color) {
 		if (color != this->color) {
 			this->color = color;
-			colorChanged = true;
+			cellFlags |= COLOR_CHANGED_BIT;
 		}
 	}
 
 	bool isBoosting() { return boost.d > 1; };
 
-	virtual CellType getType() = 0;
-	virtual bool isSpiked() = 0;
-	virtual bool isAgitated() = 0;
+	// Fixed per type, see Interactions.h for what types do to each other
+	CellType getType() { return type; };
+	bool isSpiked() { return SPIKED_MASK & cellTypeMask(type); };
+	bool isAgitated() { return false; };
 
 	virtual string_view getName() = 0;
 	virtual string_view getSkin() = 0;
 
-	virtual bool shouldAvoidWhenSpawning() = 0;
-	bool shouldUpdate() { return posChanged || sizeChanged || colorChanged || nameChanged || skinChanged; };
+	// Ownerless player cells are left to decay, spawns may land on them
+	bool shouldAvoidWhenSpawning() { return (SPAWN_AVOID_MASK & cellTypeMask(type)) && (type != PLAYER || owner); };
+	bool shouldUpdate() { return cellFlags & CHANGED_BITS; };
 	unsigned long getAge();
 
 	float getSquareSize() { return size * size; };
@@ -132,15 +158,13 @@ public:
 	float getMass() { return size * size / 100; };
 	void setMass(float s) { size = sqrt(100 * s); };
 
-	virtual EatResult getEatResult(Cell* other) = 0;
-
-	void onTickDefault() { posChanged = sizeChanged = colorChanged = nameChanged = skinChanged = false; };
+	void onTickDefault() { cellFlags &= ~CHANGED_BITS; };
 	virtual void onTick() = 0;
 
 	void whenAteDefault(Cell* other) { setSquareSize(getSquareSize() + other->getSquareSize()); };
 	virtual void whenAte(Cell* other) = 0;
 
-	void whenEatenByDefault(Cell* other) { eatenBy = other; if (data) data->eatenById = other->id; };
+	void whenEatenByDefault(Cell* other) { eatenBy = other->handle; eatenById = other->id; if (data) data->eatenById = other->id; };
 	virtual void whenEatenBy(Cell* other) = 0;
 
 	virtual void onSpawned() = 0;
@@ -155,14 +179,8 @@ public:
 	PlayerCell(World* world, Player* owner, float x, float y, float size);
 	float getMoveSpeed(); 
 	bool canMerge() { return _canMerge; };
-	CellType getType() { return PLAYER; };
-	bool isSpiked() { return false; };
-	bool isAgitated() { return false; };
-	bool shouldAvoidWhenSpawning() { return owner ? true : false; };
 	string_view getName();
 	string_view getSkin();
-	EatResult getEatResult(Cell* other);
-	EatResult getDefaultEatResult(Cell* other);
 	void whenAte(Cell* other) { Cell::whenAteDefault(other); };
 	void whenEatenBy(Cell* other) { Cell::whenEatenByDefault(other); };
 	void onTick();
@@ -175,14 +193,8 @@ public:
 	int fedTimes = 0;
 	float splitAngle = 0;
 	Virus(World* world, float x, float y);
-	CellType getType() { return VIRUS; };
 	string_view getName() { return string_view(""); };
 	string_view getSkin() { return string_view(""); };
-	bool isSpiked() { return true; };
-	bool isAgitated() { return false; };
-	bool shouldAvoidWhenSpawning() { return true; };
-	EatResult getEatResult(Cell* other); 
-	EatResult getEjectedEatResult(bool isSelf);
 	void onTick() { Cell::onTickDefault(); };
 	void whenAte(Cell* cell);
 	void whenEatenBy(Cell* cell);
@@ -193,13 +205,8 @@ public:
 class EjectedCell : public Cell {
 public:
 	EjectedCell(World* world, Player* owner, float x, float y, unsigned int color);
-	CellType getType() { return EJECTED_CELL; };
 	string_view getName() { return string_view(""); };
 	string_view getSkin() { return string_view(""); };
-	bool isSpiked() { return false; };
-	bool isAgitated() { return false; };
-	bool shouldAvoidWhenSpawning() { return false; };
-	EatResult getEatResult(Cell* other);
 	void onTick() { Cell::onTickDefault(); };
 	void whenAte(Cell* other) { Cell::whenAteDefault(other); };
 	void whenEatenBy(Cell* other) { Cell::whenEatenByDefault(other); };
@@ -210,16 +217,11 @@ public:
 class Pellet : public Cell {
 public:
 	Spawner* spawner;
-	unsigned long lastGrowTick;
 	Pellet(World* world, Spawner* spawner, float x, float y);
-	CellType getType() { return PELLET; };
 	string_view getName() { return string_view(""); };
 	string_view getSkin() { return string_view(""); };
-	bool isSpiked() { return false; };
-	bool isAgitated() { return false; };
-	bool shouldAvoidWhenSpawning() { return false; };
-	EatResult getEatResult(Cell* other) { return EatResult::NONE; };
-	void onTick();
+	// Growth is scheduled by World::growPellets, the world loop does not tick pellets
+	void onTick() { Cell::onTickDefault(); };
 	void whenAte(Cell* other) { Cell::whenAteDefault(other); };
 	void whenEatenBy(Cell* other) { Cell::whenEatenByDefault(other); };
 	void onSpawned();
@@ -231,13 +233,8 @@ public:
 	float activePelletFromQueue  = 0.0;
 	float passivePelletFromQueue = 0.0;
 	MotherCell(World* world, float x, float y);
-	CellType getType() { return MOTHER_CELL; };
 	string_view getName() { return string_view(""); };
 	string_view getSkin() { return string_view(""); };
-	bool isSpiked() { return true; };
-	bool isAgitated() { return false; };
-	bool shouldAvoidWhenSpawning() { return true; };
-	EatResult getEatResult(Cell* other) { return EatResult::NONE; };
 	void onTick();
 	void whenAte(Cell* cell);
 	void whenEatenBy(Cell* cell);
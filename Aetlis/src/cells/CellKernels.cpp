@@ -0,0 +1,239 @@
+#include "CellKernels.h"
+
+#include <cmath>
+#include <algorithm>
+
+#if defined(PLAYER_KERNELS_X86) && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+void PlayerCellBatch::resize(unsigned int count) {
+	this->count = count;
+	unsigned int padded = (count + PLAYER_BATCH_LANES - 1) / PLAYER_BATCH_LANES * PLAYER_BATCH_LANES;
+	x.resize(padded);
+	y.resize(padded);
+	// Padding lanes stay still at size 1, which keeps the vector log away from zero
+	size.resize(padded);
+	for (unsigned int i = count; i < padded; i++) size[i] = 1;
+	targetX.resize(padded);
+	targetY.resize(padded);
+	lineA.resize(padded);
+	lineB.resize(padded);
+	lineC.resize(padded);
+	lineInv.resize(padded);
+	flags.assign(padded, 0);
+}
+
+PlayerCellLanes PlayerCellBatch::lanes() {
+	return { x.data(), y.data(), size.data(), targetX.data(), targetY.data(),
+		lineA.data(), lineB.data(), lineC.data(), lineInv.data(), flags.data() };
+}
+
+unsigned int ContactBatch::pad() {
+	unsigned int padded = (count + PLAYER_BATCH_LANES - 1) / PLAYER_BATCH_LANES * PLAYER_BATCH_LANES;
+	for (unsigned int i = count; i < padded; i++)
+		probeX[i] = probeY[i] = probeSize[i] = x[i] = y[i] = size[i] = 0;
+	return padded;
+}
+
+ContactLanes ContactBatch::lanes() {
+	return { probeX, probeY, probeSize, x, y, size, flags };
+}
+
+void ParticleBatch::resize(unsigned int count) {
+	this->count = count;
+	x.resize(count);
+	y.resize(count);
+	dx.resize(count);
+	dy.resize(count);
+	d.resize(count);
+	size.resize(count);
+}
+
+void CellGroup::resize(unsigned int count) {
+	this->count = count;
+	x.resize(count);
+	y.resize(count);
+	size.resize(count);
+	left.resize(count);
+	order.resize(count);
+}
+
+KernelLevel detectKernelLevel() {
+#if !defined(PLAYER_KERNELS_X86)
+	return KernelLevel::SCALAR;
+#elif defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 0);
+	int leaves = info[0];
+	__cpuid(info, 1);
+	bool sse4 = info[2] & (1 << 19);
+	bool osxsave = info[2] & (1 << 27);
+	bool avx = info[2] & (1 << 28);
+	bool avx2 = false;
+	if (leaves >= 7 && osxsave && avx && (_xgetbv(0) & 6) == 6) {
+		__cpuidex(info, 7, 0);
+		avx2 = info[1] & (1 << 5);
+	}
+	return avx2 ? KernelLevel::AVX2 : sse4 ? KernelLevel::SSE4 : KernelLevel::SCALAR;
+#else
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2")) return KernelLevel::AVX2;
+	if (__builtin_cpu_supports("sse4.1")) return KernelLevel::SSE4;
+	return KernelLevel::SCALAR;
+#endif
+}
+
+const char* kernelLevelName(KernelLevel level) {
+	switch (level) {
+		case KernelLevel::AVX2: return "avx2";
+		case KernelLevel::SSE4: return "sse4.1";
+		default: return "scalar";
+	}
+}
+
+void integratePlayerCells(PlayerCellBatch& batch, const PlayerCellParams& params, unsigned int from, unsigned int to) {
+	static const KernelLevel level = detectKernelLevel();
+	integratePlayerCells(batch, params, from, to, level);
+}
+
+void integratePlayerCells(PlayerCellBatch& batch, const PlayerCellParams& params, unsigned int from, unsigned int to, KernelLevel level) {
+	static const KernelLevel supported = detectKernelLevel();
+	level = std::min(level, supported);
+#ifdef PLAYER_KERNELS_X86
+	if (level == KernelLevel::AVX2) return integratePlayerCellsAVX2(batch.lanes(), params, from, to);
+	if (level == KernelLevel::SSE4) return integratePlayerCellsSSE4(batch.lanes(), params, from, to);
+#endif
+	integratePlayerCellsScalar(batch, params, from, to);
+}
+
+// Step for step what World::movePlayerCell, Gamemode::getDecayMult and bounceCell do
+void integratePlayerCellsScalar(PlayerCellBatch& batch, const PlayerCellParams& params, unsigned int from, unsigned int to) {
+	for (unsigned int i = from; i < to; i++) {
+		float x = batch.x[i], y = batch.y[i], size = batch.size[i];
+		unsigned char flags = batch.flags[i];
+
+		if (flags & PLAYER_MOVES) {
+			float dx = batch.targetX[i] - x;
+			float dy = batch.targetY[i] - y;
+			float d = std::sqrt(dx * dx + dy * dy);
+			if (d >= 1) {
+				dx /= d;
+				dy /= d;
+				float speed = 88.0f * std::pow(size, -0.39f) * params.moveMult;
+				float m = std::min(speed, d) * params.stepMult;
+				x = x + dx * m;
+				y = y + dy * m;
+				if (flags & PLAYER_LOCKED) {
+					float a = batch.lineA[i], b = batch.lineB[i], c = batch.lineC[i];
+					float projectedX = (b * (b * x - a * y) - a * c) * batch.lineInv[i];
+					float projectedY = (a * (-b * x + a * y) - b * c) * batch.lineInv[i];
+					x = projectedX;
+					y = projectedY;
+				}
+			}
+		}
+
+		float mult = params.decayMult;
+		float mass = size * size / 100;
+		if (mass > 250000) mult = mult * (std::pow(mass / 250000.0f, 3.0f) * 10.0f);
+		size = std::max(size - size * mult / 50 * params.stepMult, params.minSize);
+
+		if (!(flags & PLAYER_OWNED) || size * size <= params.splitSquareSize) {
+			float r = size / 2.0f;
+			if (x <= params.left + r) x = params.left + r;
+			if (x >= params.right - r) x = params.right - r;
+			if (y <= params.bottom + r) y = params.bottom + r;
+			if (y >= params.top - r) y = params.top - r;
+		}
+
+		batch.x[i] = x;
+		batch.y[i] = y;
+		batch.size[i] = size;
+	}
+}
+
+void testContacts(ContactBatch& batch, unsigned int from, unsigned int to) {
+	static const KernelLevel level = detectKernelLevel();
+	testContacts(batch, from, to, level);
+}
+
+void testContacts(ContactBatch& batch, unsigned int from, unsigned int to, KernelLevel level) {
+	static const KernelLevel supported = detectKernelLevel();
+	level = std::min(level, supported);
+#ifdef PLAYER_KERNELS_X86
+	if (level == KernelLevel::AVX2) return testContactsAVX2(batch.lanes(), from, to);
+	if (level == KernelLevel::SSE4) return testContactsSSE4(batch.lanes(), from, to);
+#endif
+	testContactsScalar(batch, from, to);
+}
+
+// The tests the collision pass used to make per pair, sizes are compared to the squared
+// distance as they always were
+void testContactsScalar(ContactBatch& batch, unsigned int from, unsigned int to) {
+	for (unsigned int i = from; i < to; i++) {
+		float probeSize = batch.probeSize[i], size = batch.size[i];
+		float dx = batch.probeX[i] - batch.x[i];
+		float dy = batch.probeY[i] - batch.y[i];
+		float dSq = dx * dx + dy * dy;
+		float reach = probeSize + size;
+		unsigned char flags = 0;
+		if (dSq < reach * reach) {
+			flags = CONTACT_TOUCH;
+			if (probeSize > size) {
+				if (dSq < probeSize) flags |= CONTACT_OTHER_INSIDE;
+			} else {
+				if (dSq < size) flags |= CONTACT_PROBE_INSIDE;
+				if (probeSize == size && dSq < size) flags |= CONTACT_TIE;
+			}
+		}
+		batch.flags[i] = flags;
+	}
+}
+
+// Step for step what World::boostCell and bounceCell do
+void integrateParticles(ParticleBatch& batch, const ParticleParams& params, unsigned int from, unsigned int to) {
+	for (unsigned int i = from; i < to; i++) {
+		float d = batch.d[i] / 9 * params.stepMult;
+		float dx = batch.dx[i], dy = batch.dy[i];
+		float x = batch.x[i] + dx * d;
+		float y = batch.y[i] + dy * d;
+		float r = batch.size[i] / 2.0f;
+		if (x <= params.left + r) x = params.left + r, dx = -dx;
+		if (x >= params.right - r) x = params.right - r, dx = -dx;
+		if (y <= params.bottom + r) y = params.bottom + r, dy = -dy;
+		if (y >= params.top - r) y = params.top - r, dy = -dy;
+		batch.x[i] = x;
+		batch.y[i] = y;
+		batch.dx[i] = dx;
+		batch.dy[i] = dy;
+		batch.d[i] -= d;
+	}
+}
+
+// Cells touch when their x spans overlap, so the scan for a cell stops at the first one that
+// starts past its right edge. A player's cells bunch up, most of them are still culled.
+void findGroupContacts(CellGroup& group, std::vector<GroupContact>& contacts) {
+	contacts.clear();
+	for (unsigned int i = 0; i < group.count; i++) {
+		group.left[i] = group.x[i] - group.size[i];
+		group.order[i] = i;
+	}
+	std::sort(group.order.begin(), group.order.begin() + group.count, [&group](unsigned int a, unsigned int b) {
+		return group.left[a] < group.left[b];
+	});
+	for (unsigned int i = 0; i < group.count; i++) {
+		unsigned int a = group.order[i];
+		float x = group.x[a], y = group.y[a], size = group.size[a];
+		float right = x + size;
+		for (unsigned int j = i + 1; j < group.count; j++) {
+			unsigned int b = group.order[j];
+			if (group.left[b] >= right) break;
+			float dx = x - group.x[b];
+			float dy = y - group.y[b];
+			float dSq = dx * dx + dy * dy;
+			float reach = size + group.size[b];
+			if (dSq < reach * reach) contacts.push_back({ a, b, dSq });
+		}
+	}
+}
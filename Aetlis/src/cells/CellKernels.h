@@ -0,0 +1,191 @@
+#pragma once
+
+#include <vector>
+
+// Cell physics over struct-of-arrays batches. Player cell integration takes the steps
+// World::movePlayerCell, decayPlayerCell and bounceCell take one cell at a time, contact tests
+// are the narrow phase of the collision pass. SSE4.1 and AVX2 versions live in their own
+// translation units built for that instruction set and are picked at runtime. Ejected cells
+// in flight are moved by a plain loop the compiler vectorises on its own, the cells of one
+// player find each other with a sweep over x.
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define PLAYER_KERNELS_X86
+#endif
+
+enum class KernelLevel : unsigned char {
+	SCALAR,
+	SSE4,
+	AVX2
+};
+
+// Batch flags
+const unsigned char PLAYER_MOVES  = 0x01; // owner is connected, follows its mouse
+const unsigned char PLAYER_LOCKED = 0x02; // projected onto the owner's line after moving
+const unsigned char PLAYER_OWNED  = 0x04; // may autosplit, left unclamped when big enough to
+
+// Batches are padded to a multiple of this, so vector loops never need a scalar tail
+const unsigned int PLAYER_BATCH_LANES = 8;
+
+// Contact flags, all but CONTACT_TOUCH only set on touching pairs
+const unsigned char CONTACT_TOUCH        = 0x01; // closer than the sum of both sizes
+const unsigned char CONTACT_PROBE_INSIDE = 0x02; // probe is not the bigger one and its center is in the other
+const unsigned char CONTACT_OTHER_INSIDE = 0x04; // probe is the bigger one and the other's center is in it
+const unsigned char CONTACT_TIE          = 0x08; // same size and centers this close, marks the other from its side
+
+struct PlayerCellParams {
+	float moveMult = 1;
+	float stepMult = 1;
+	float decayMult = 0;
+	float minSize = 0;
+	float splitSquareSize = 0;
+	float left = 0;
+	float right = 0;
+	float bottom = 0;
+	float top = 0;
+};
+
+// Raw view of a batch for the vector units, which must not call into inline library code
+struct PlayerCellLanes {
+	float* x;
+	float* y;
+	float* size;
+	const float* targetX;
+	const float* targetY;
+	const float* lineA;
+	const float* lineB;
+	const float* lineC;
+	const float* lineInv;
+	const unsigned char* flags;
+};
+
+struct PlayerCellBatch {
+	std::vector<float> x;
+	std::vector<float> y;
+	std::vector<float> size;
+	std::vector<float> targetX;
+	std::vector<float> targetY;
+	std::vector<float> lineA;
+	std::vector<float> lineB;
+	std::vector<float> lineC;
+	std::vector<float> lineInv;
+	std::vector<unsigned char> flags;
+	unsigned int count = 0;
+
+	void resize(unsigned int count);
+	PlayerCellLanes lanes();
+	unsigned int padded() const { return (unsigned int) flags.size(); };
+};
+
+KernelLevel detectKernelLevel();
+const char* kernelLevelName(KernelLevel level);
+
+// Integrates cells [from, to), both multiples of PLAYER_BATCH_LANES, at the best level this
+// CPU runs or at most at the given one
+void integratePlayerCells(PlayerCellBatch& batch, const PlayerCellParams& params, unsigned int from, unsigned int to);
+void integratePlayerCells(PlayerCellBatch& batch, const PlayerCellParams& params, unsigned int from, unsigned int to, KernelLevel level);
+
+void integratePlayerCellsScalar(PlayerCellBatch& batch, const PlayerCellParams& params, unsigned int from, unsigned int to);
+#ifdef PLAYER_KERNELS_X86
+void integratePlayerCellsSSE4(const PlayerCellLanes& lanes, const PlayerCellParams& params, unsigned int from, unsigned int to);
+void integratePlayerCellsAVX2(const PlayerCellLanes& lanes, const PlayerCellParams& params, unsigned int from, unsigned int to);
+#endif
+
+// Pairs a contact batch holds, small enough to stay in cache while it is filled and tested
+const unsigned int CONTACT_BATCH_SIZE = 512;
+
+// Raw view of a contact batch for the vector units
+struct ContactLanes {
+	const float* probeX;
+	const float* probeY;
+	const float* probeSize;
+	const float* x;
+	const float* y;
+	const float* size;
+	unsigned char* flags;
+};
+
+// Candidate pairs of the broad phase, a probe and a cell it may touch. Filled until full(),
+// then padded and tested.
+struct ContactBatch {
+	alignas(32) float probeX[CONTACT_BATCH_SIZE];
+	alignas(32) float probeY[CONTACT_BATCH_SIZE];
+	alignas(32) float probeSize[CONTACT_BATCH_SIZE];
+	alignas(32) float x[CONTACT_BATCH_SIZE];
+	alignas(32) float y[CONTACT_BATCH_SIZE];
+	alignas(32) float size[CONTACT_BATCH_SIZE];
+	unsigned char flags[CONTACT_BATCH_SIZE];
+	unsigned int count = 0;
+
+	void clear() { count = 0; };
+	bool full() const { return count == CONTACT_BATCH_SIZE; };
+	void add(float probeX, float probeY, float probeSize, float x, float y, float size) {
+		this->probeX[count] = probeX;
+		this->probeY[count] = probeY;
+		this->probeSize[count] = probeSize;
+		this->x[count] = x;
+		this->y[count] = y;
+		this->size[count] = size;
+		count++;
+	};
+	// Fills up to a multiple of PLAYER_BATCH_LANES with pairs at size 0, which never touch,
+	// and returns that
+	unsigned int pad();
+	ContactLanes lanes();
+};
+
+// Flags pairs [from, to) of a padded batch, same squared distance test as the finders do
+void testContacts(ContactBatch& batch, unsigned int from, unsigned int to);
+void testContacts(ContactBatch& batch, unsigned int from, unsigned int to, KernelLevel level);
+
+void testContactsScalar(ContactBatch& batch, unsigned int from, unsigned int to);
+#ifdef PLAYER_KERNELS_X86
+void testContactsSSE4(const ContactLanes& lanes, unsigned int from, unsigned int to);
+void testContactsAVX2(const ContactLanes& lanes, unsigned int from, unsigned int to);
+#endif
+
+// Ejected cells in flight, see World::moveParticles
+struct ParticleBatch {
+	std::vector<float> x;
+	std::vector<float> y;
+	std::vector<float> dx;
+	std::vector<float> dy;
+	std::vector<float> d;
+	std::vector<float> size;
+	unsigned int count = 0;
+
+	void resize(unsigned int count);
+};
+
+struct ParticleParams {
+	float stepMult = 1;
+	float left = 0;
+	float right = 0;
+	float bottom = 0;
+	float top = 0;
+};
+
+// Moves particles [from, to) one boost step and bounces them off the border, all are boosting
+void integrateParticles(ParticleBatch& batch, const ParticleParams& params, unsigned int from, unsigned int to);
+
+// One player's cells for the own cell solver, see World::solvePlayerGroups
+struct CellGroup {
+	std::vector<float> x;
+	std::vector<float> y;
+	std::vector<float> size;
+	std::vector<float> left;
+	std::vector<unsigned int> order;
+	unsigned int count = 0;
+
+	void resize(unsigned int count);
+};
+
+// Two touching cells of a group by index, a comes first in x order
+struct GroupContact {
+	unsigned int a;
+	unsigned int b;
+	float dSq;
+};
+
+// Sorts the group by left edge and sweeps it, every touching pair is added once
+void findGroupContacts(CellGroup& group, std::vector<GroupContact>& contacts);
@@ -0,0 +1,72 @@
+// Built with AVX2 enabled, only called once detectKernelLevel has seen the CPU support it
+
+#include "CellKernels.h"
+
+#ifdef PLAYER_KERNELS_X86
+
+#include <immintrin.h>
+#include "CellKernelsSimd.h"
+
+namespace {
+
+struct Avx2 {
+	typedef __m256 F;
+	typedef __m256i I;
+	static const unsigned int width = 8;
+
+	static F set1(float v) { return _mm256_set1_ps(v); }
+	static I set1i(int v) { return _mm256_set1_epi32(v); }
+	static F load(const float* p) { return _mm256_loadu_ps(p); }
+	static void store(float* p, F v) { _mm256_storeu_ps(p, v); }
+	static I loadFlags(const unsigned char* p) {
+		return _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*) p));
+	}
+	// Lanes hold values below 256, packed down to a byte each
+	static void storeFlags(unsigned char* p, I flags) {
+		__m128i words = _mm_packus_epi32(_mm256_castsi256_si128(flags), _mm256_extracti128_si256(flags, 1));
+		_mm_storel_epi64((__m128i*) p, _mm_packus_epi16(words, words));
+	}
+	static F flag(I flags, unsigned char bit) {
+		I mask = _mm256_set1_epi32(bit);
+		return _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(flags, mask), mask));
+	}
+
+	static F add(F a, F b) { return _mm256_add_ps(a, b); }
+	static F sub(F a, F b) { return _mm256_sub_ps(a, b); }
+	static F mul(F a, F b) { return _mm256_mul_ps(a, b); }
+	static F div(F a, F b) { return _mm256_div_ps(a, b); }
+	static F sqrt(F a) { return _mm256_sqrt_ps(a); }
+	static F min(F a, F b) { return _mm256_min_ps(a, b); }
+	static F max(F a, F b) { return _mm256_max_ps(a, b); }
+	static F both(F a, F b) { return _mm256_and_ps(a, b); }
+	static F greater(F a, F b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+	static F greaterEqual(F a, F b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+	static F lessEqual(F a, F b) { return _mm256_cmp_ps(a, b, _CMP_LE_OQ); }
+	static F less(F a, F b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+	static F equal(F a, F b) { return _mm256_cmp_ps(a, b, _CMP_EQ_OQ); }
+	// b where mask is set, a elsewhere
+	static F blend(F a, F b, F mask) { return _mm256_blendv_ps(a, b, mask); }
+
+	static I asInt(F a) { return _mm256_castps_si256(a); }
+	static F asFloat(I a) { return _mm256_castsi256_ps(a); }
+	static F toFloat(I a) { return _mm256_cvtepi32_ps(a); }
+	static I toNearestInt(F a) { return _mm256_cvtps_epi32(a); }
+	static I add32(I a, I b) { return _mm256_add_epi32(a, b); }
+	static I sub32(I a, I b) { return _mm256_sub_epi32(a, b); }
+	static I and32(I a, I b) { return _mm256_and_si256(a, b); }
+	static I or32(I a, I b) { return _mm256_or_si256(a, b); }
+	static I shiftLeft32(I a, int n) { return _mm256_slli_epi32(a, n); }
+	static I shiftRight32(I a, int n) { return _mm256_srli_epi32(a, n); }
+};
+
+}
+
+void integratePlayerCellsAVX2(const PlayerCellLanes& lanes, const PlayerCellParams& params, unsigned int from, unsigned int to) {
+	integrateLanes<Avx2>(lanes, params, from, to);
+}
+
+void testContactsAVX2(const ContactLanes& lanes, unsigned int from, unsigned int to) {
+	contactLanes<Avx2>(lanes, from, to);
+}
+
+#endif
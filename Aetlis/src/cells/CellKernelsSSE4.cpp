@@ -0,0 +1,74 @@
+// Built with SSE4.1 enabled, only called once detectKernelLevel has seen the CPU support it
+
+#include "CellKernels.h"
+
+#ifdef PLAYER_KERNELS_X86
+
+#include <smmintrin.h>
+#include "CellKernelsSimd.h"
+
+namespace {
+
+struct Sse4 {
+	typedef __m128 F;
+	typedef __m128i I;
+	static const unsigned int width = 4;
+
+	static F set1(float v) { return _mm_set1_ps(v); }
+	static I set1i(int v) { return _mm_set1_epi32(v); }
+	static F load(const float* p) { return _mm_loadu_ps(p); }
+	static void store(float* p, F v) { _mm_storeu_ps(p, v); }
+	static I loadFlags(const unsigned char* p) {
+		int packed = p[0] | p[1] << 8 | p[2] << 16 | p[3] << 24;
+		return _mm_cvtepu8_epi32(_mm_cvtsi32_si128(packed));
+	}
+	// Lanes hold values below 256, packed down to a byte each
+	static void storeFlags(unsigned char* p, I flags) {
+		I packed = _mm_packus_epi16(_mm_packus_epi32(flags, flags), flags);
+		int bytes = _mm_cvtsi128_si32(packed);
+		for (int k = 0; k < 4; k++) p[k] = (unsigned char) (bytes >> (8 * k));
+	}
+	static F flag(I flags, unsigned char bit) {
+		I mask = _mm_set1_epi32(bit);
+		return _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(flags, mask), mask));
+	}
+
+	static F add(F a, F b) { return _mm_add_ps(a, b); }
+	static F sub(F a, F b) { return _mm_sub_ps(a, b); }
+	static F mul(F a, F b) { return _mm_mul_ps(a, b); }
+	static F div(F a, F b) { return _mm_div_ps(a, b); }
+	static F sqrt(F a) { return _mm_sqrt_ps(a); }
+	static F min(F a, F b) { return _mm_min_ps(a, b); }
+	static F max(F a, F b) { return _mm_max_ps(a, b); }
+	static F both(F a, F b) { return _mm_and_ps(a, b); }
+	static F greater(F a, F b) { return _mm_cmpgt_ps(a, b); }
+	static F greaterEqual(F a, F b) { return _mm_cmpge_ps(a, b); }
+	static F lessEqual(F a, F b) { return _mm_cmple_ps(a, b); }
+	static F less(F a, F b) { return _mm_cmplt_ps(a, b); }
+	static F equal(F a, F b) { return _mm_cmpeq_ps(a, b); }
+	// b where mask is set, a elsewhere
+	static F blend(F a, F b, F mask) { return _mm_blendv_ps(a, b, mask); }
+
+	static I asInt(F a) { return _mm_castps_si128(a); }
+	static F asFloat(I a) { return _mm_castsi128_ps(a); }
+	static F toFloat(I a) { return _mm_cvtepi32_ps(a); }
+	static I toNearestInt(F a) { return _mm_cvtps_epi32(a); }
+	static I add32(I a, I b) { return _mm_add_epi32(a, b); }
+	static I sub32(I a, I b) { return _mm_sub_epi32(a, b); }
+	static I and32(I a, I b) { return _mm_and_si128(a, b); }
+	static I or32(I a, I b) { return _mm_or_si128(a, b); }
+	static I shiftLeft32(I a, int n) { return _mm_slli_epi32(a, n); }
+	static I shiftRight32(I a, int n) { return _mm_srli_epi32(a, n); }
+};
+
+}
+
+void integratePlayerCellsSSE4(const PlayerCellLanes& lanes, const PlayerCellParams& params, unsigned int from, unsigned int to) {
+	integrateLanes<Sse4>(lanes, params, from, to);
+}
+
+void testContactsSSE4(const ContactLanes& lanes, unsigned int from, unsigned int to) {
+	contactLanes<Sse4>(lanes, from, to);
+}
+
+#endif
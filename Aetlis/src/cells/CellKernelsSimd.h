@@ -0,0 +1,150 @@
+#pragma once
+
+// Vector bodies of the cell kernels, included only by the translation units built for an
+// instruction set. V wraps the intrinsics of one vector width. Everything here has internal
+// linkage and works on raw pointers without calling inline library code, so the linker can
+// never pick a copy built for a wider instruction set for the scalar path.
+
+#include "CellKernels.h"
+
+namespace {
+
+// x to the power e for x > 0, through log2 and exp2 polynomials. Within a few ulp of powf
+// for the sizes cells take.
+template<typename V>
+inline typename V::F powPositive(typename V::F x, typename V::F e) {
+	using F = typename V::F;
+	const F one = V::set1(1.0f);
+
+	// x = 2^exponent * mantissa with the mantissa in [sqrt(1/2), sqrt(2))
+	auto bits = V::asInt(x);
+	auto exponent = V::sub32(V::shiftRight32(bits, 23), V::set1i(127));
+	F mantissa = V::asFloat(V::or32(V::and32(bits, V::set1i(0x007fffff)), V::set1i(0x3f800000)));
+	F high = V::greater(mantissa, V::set1(1.41421356f));
+	mantissa = V::blend(mantissa, V::mul(mantissa, V::set1(0.5f)), high);
+	exponent = V::add32(exponent, V::and32(V::asInt(high), V::set1i(1)));
+
+	// ln(m) = 2t (1 + t^2/3 + t^4/5 + t^6/7 + t^8/9) with t = (m - 1) / (m + 1), |t| < 0.172
+	F t = V::div(V::sub(mantissa, one), V::add(mantissa, one));
+	F t2 = V::mul(t, t);
+	F series = V::add(V::mul(t2, V::set1(1.0f / 9)), V::set1(1.0f / 7));
+	series = V::add(V::mul(series, t2), V::set1(1.0f / 5));
+	series = V::add(V::mul(series, t2), V::set1(1.0f / 3));
+	series = V::add(V::mul(series, t2), one);
+	F log2x = V::add(V::toFloat(exponent), V::mul(V::mul(t, series), V::set1(2.0f / 0.693147181f)));
+
+	// 2^y = 2^n * e^(f ln 2) with n the nearest integer and f in [-0.5, 0.5]
+	F y = V::mul(log2x, e);
+	auto n = V::toNearestInt(y);
+	F g = V::mul(V::sub(y, V::toFloat(n)), V::set1(0.693147181f));
+	F taylor = V::add(V::mul(g, V::set1(1.0f / 5040)), V::set1(1.0f / 720));
+	taylor = V::add(V::mul(taylor, g), V::set1(1.0f / 120));
+	taylor = V::add(V::mul(taylor, g), V::set1(1.0f / 24));
+	taylor = V::add(V::mul(taylor, g), V::set1(1.0f / 6));
+	taylor = V::add(V::mul(taylor, g), V::set1(0.5f));
+	taylor = V::add(V::mul(taylor, g), one);
+	taylor = V::add(V::mul(taylor, g), one);
+	F scale = V::asFloat(V::shiftLeft32(V::add32(n, V::set1i(127)), 23));
+	return V::mul(taylor, scale);
+}
+
+// Same steps and operation order as integratePlayerCellsScalar, lanes that skip a step keep
+// their old value through blends. Only the powers are approximated.
+template<typename V>
+void integrateLanes(const PlayerCellLanes& lanes, const PlayerCellParams& params, unsigned int from, unsigned int to) {
+	using F = typename V::F;
+	const F one = V::set1(1.0f);
+	const F half = V::set1(0.5f);
+	const F moveMult = V::set1(params.moveMult);
+	const F stepMult = V::set1(params.stepMult);
+	const F decayMult = V::set1(params.decayMult);
+	const F minSize = V::set1(params.minSize);
+	const F splitSquareSize = V::set1(params.splitSquareSize);
+	const F left = V::set1(params.left), right = V::set1(params.right);
+	const F bottom = V::set1(params.bottom), top = V::set1(params.top);
+
+	for (unsigned int i = from; i < to; i += V::width) {
+		F x = V::load(lanes.x + i);
+		F y = V::load(lanes.y + i);
+		F size = V::load(lanes.size + i);
+		auto flags = V::loadFlags(lanes.flags + i);
+
+		F dx = V::sub(V::load(lanes.targetX + i), x);
+		F dy = V::sub(V::load(lanes.targetY + i), y);
+		F d = V::sqrt(V::add(V::mul(dx, dx), V::mul(dy, dy)));
+		F moving = V::both(V::flag(flags, PLAYER_MOVES), V::greaterEqual(d, one));
+		// Lanes that stay put divide by 1, so nothing turns into NaN
+		F safeD = V::blend(one, d, moving);
+		dx = V::div(dx, safeD);
+		dy = V::div(dy, safeD);
+		F speed = V::mul(V::mul(V::set1(88.0f), powPositive<V>(size, V::set1(-0.39f))), moveMult);
+		F m = V::mul(V::min(speed, d), stepMult);
+		F movedX = V::add(x, V::mul(dx, m));
+		F movedY = V::add(y, V::mul(dy, m));
+
+		F a = V::load(lanes.lineA + i);
+		F b = V::load(lanes.lineB + i);
+		F c = V::load(lanes.lineC + i);
+		F inv = V::load(lanes.lineInv + i);
+		F projectedX = V::mul(V::sub(V::mul(b, V::sub(V::mul(b, movedX), V::mul(a, movedY))), V::mul(a, c)), inv);
+		F projectedY = V::mul(V::sub(V::mul(a, V::sub(V::mul(a, movedY), V::mul(b, movedX))), V::mul(b, c)), inv);
+		F locked = V::flag(flags, PLAYER_LOCKED);
+		movedX = V::blend(movedX, projectedX, locked);
+		movedY = V::blend(movedY, projectedY, locked);
+		x = V::blend(x, movedX, moving);
+		y = V::blend(y, movedY, moving);
+
+		F mass = V::div(V::mul(size, size), V::set1(100.0f));
+		F ratio = V::div(mass, V::set1(250000.0f));
+		F heavyMult = V::mul(decayMult, V::mul(V::mul(V::mul(ratio, ratio), ratio), V::set1(10.0f)));
+		F mult = V::blend(decayMult, heavyMult, V::greater(mass, V::set1(250000.0f)));
+		size = V::max(V::sub(size, V::mul(V::div(V::mul(size, mult), V::set1(50.0f)), stepMult)), minSize);
+
+		F splitting = V::both(V::flag(flags, PLAYER_OWNED), V::greater(V::mul(size, size), splitSquareSize));
+		F r = V::mul(size, half);
+		F clampedX = x, clampedY = y;
+		F edge = V::add(left, r);
+		clampedX = V::blend(clampedX, edge, V::lessEqual(clampedX, edge));
+		edge = V::sub(right, r);
+		clampedX = V::blend(clampedX, edge, V::greaterEqual(clampedX, edge));
+		edge = V::add(bottom, r);
+		clampedY = V::blend(clampedY, edge, V::lessEqual(clampedY, edge));
+		edge = V::sub(top, r);
+		clampedY = V::blend(clampedY, edge, V::greaterEqual(clampedY, edge));
+		x = V::blend(clampedX, x, splitting);
+		y = V::blend(clampedY, y, splitting);
+
+		V::store(lanes.x + i, x);
+		V::store(lanes.y + i, y);
+		V::store(lanes.size + i, size);
+	}
+}
+
+// Same tests as testContactsScalar, the comparison masks become one flag byte per lane
+template<typename V>
+void contactLanes(const ContactLanes& lanes, unsigned int from, unsigned int to) {
+	using F = typename V::F;
+	using I = typename V::I;
+
+	for (unsigned int i = from; i < to; i += V::width) {
+		F probeSize = V::load(lanes.probeSize + i);
+		F size = V::load(lanes.size + i);
+		F dx = V::sub(V::load(lanes.probeX + i), V::load(lanes.x + i));
+		F dy = V::sub(V::load(lanes.probeY + i), V::load(lanes.y + i));
+		F dSq = V::add(V::mul(dx, dx), V::mul(dy, dy));
+		F reach = V::add(probeSize, size);
+		F touch = V::less(dSq, V::mul(reach, reach));
+		F inSize = V::both(touch, V::less(dSq, size));
+
+		I flags = V::and32(V::asInt(touch), V::set1i(CONTACT_TOUCH));
+		I probeInside = V::asInt(V::both(inSize, V::lessEqual(probeSize, size)));
+		flags = V::or32(flags, V::and32(probeInside, V::set1i(CONTACT_PROBE_INSIDE)));
+		I otherInside = V::asInt(V::both(touch, V::both(V::greater(probeSize, size), V::less(dSq, probeSize))));
+		flags = V::or32(flags, V::and32(otherInside, V::set1i(CONTACT_OTHER_INSIDE)));
+		I tie = V::asInt(V::both(inSize, V::equal(probeSize, size)));
+		flags = V::or32(flags, V::and32(tie, V::set1i(CONTACT_TIE)));
+		V::storeFlags(lanes.flags + i, flags);
+	}
+}
+
+}
@@ -0,0 +1,155 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <new>
+#include <utility>
+#include "Cell.h"
+
+// Handle layout: cell type in the top 3 bits, slot generation in the next 8, slot in the low 21
+const unsigned int HANDLE_SLOT_BITS = 21;
+const unsigned int HANDLE_GENERATION_BITS = 8;
+const unsigned int HANDLE_SLOT_MASK = (1U << HANDLE_SLOT_BITS) - 1;
+const unsigned int HANDLE_GENERATION_MASK = (1U << HANDLE_GENERATION_BITS) - 1;
+
+constexpr CellHandle makeCellHandle(CellType type, unsigned int slot, unsigned char generation) {
+	return ((unsigned int) type << (HANDLE_SLOT_BITS + HANDLE_GENERATION_BITS)) |
+		((unsigned int) generation << HANDLE_SLOT_BITS) | slot;
+}
+constexpr CellType handleType(CellHandle handle) { return (CellType) (handle >> (HANDLE_SLOT_BITS + HANDLE_GENERATION_BITS)); }
+constexpr unsigned int handleSlot(CellHandle handle) { return handle & HANDLE_SLOT_MASK; }
+constexpr unsigned char handleGeneration(CellHandle handle) { return (handle >> HANDLE_SLOT_BITS) & HANDLE_GENERATION_MASK; }
+
+// Cells of one type in fixed chunks that never move, freed slots are reused before the slab
+// grows. Each slot has a generation, bumped when its cell is retired, so a handle taken before
+// that no longer resolves. Retired cells stay constructed until released, code still holding a
+// plain pointer to one can read it until then.
+template<typename T, CellType TYPE>
+class CellSlab {
+	static const unsigned int CHUNK_SIZE = 1024;
+	struct alignas(T) Slot { unsigned char bytes[sizeof(T)]; };
+
+	std::vector<std::unique_ptr<Slot[]>> chunks;
+	std::vector<unsigned char> generations; // never 0, so handle 0 resolves to nothing
+	std::vector<unsigned char> used;
+	std::vector<unsigned int> freeSlots;
+	std::deque<std::pair<unsigned int, unsigned long>> retired; // slot and the tick it was retired on
+
+	T* at(unsigned int slot) { return reinterpret_cast<T*>(chunks[slot / CHUNK_SIZE][slot % CHUNK_SIZE].bytes); };
+
+	void bump(unsigned int slot) {
+		if (!++generations[slot]) generations[slot] = 1;
+	}
+
+	void destroy(unsigned int slot) {
+		at(slot)->~T();
+		used[slot] = 0;
+		freeSlots.push_back(slot);
+	}
+
+public:
+	CellSlab() = default;
+	CellSlab(const CellSlab&) = delete;
+	CellSlab& operator=(const CellSlab&) = delete;
+	~CellSlab() { clear(); };
+
+	template<typename... Args>
+	T* create(Args&&... args) {
+		if (freeSlots.empty()) {
+			unsigned int base = generations.size();
+			if (base + CHUNK_SIZE > HANDLE_SLOT_MASK + 1) throw std::bad_alloc();
+			chunks.emplace_back(new Slot[CHUNK_SIZE]);
+			generations.resize(base + CHUNK_SIZE, 1);
+			used.resize(base + CHUNK_SIZE, 0);
+			// Reversed so slots are handed out in address order
+			for (unsigned int i = base + CHUNK_SIZE; i > base; i--) freeSlots.push_back(i - 1);
+		}
+		unsigned int slot = freeSlots.back();
+		auto cell = new (at(slot)) T(std::forward<Args>(args)...);
+		freeSlots.pop_back();
+		used[slot] = 1;
+		cell->handle = makeCellHandle(TYPE, slot, generations[slot]);
+		return cell;
+	}
+
+	T* get(CellHandle handle) {
+		unsigned int slot = handleSlot(handle);
+		if (slot >= generations.size() || generations[slot] != handleGeneration(handle) || !used[slot]) return nullptr;
+		return at(slot);
+	}
+
+	// Stales the cell's handles now, its memory goes back to the slab in release
+	void retire(T* cell, unsigned long tick) {
+		unsigned int slot = handleSlot(cell->handle);
+		bump(slot);
+		retired.push_back(std::make_pair(slot, tick));
+	}
+
+	// Destroys cells retired on or before tick, their slots are reused by later creates
+	void release(unsigned long tick) {
+		while (!retired.empty() && retired.front().second <= tick) {
+			destroy(retired.front().first);
+			retired.pop_front();
+		}
+	}
+
+	// Destroys every cell, live or retired, and stales all handles
+	void clear() {
+		retired.clear();
+		for (unsigned int slot = 0; slot < used.size(); slot++) {
+			if (!used[slot]) continue;
+			bump(slot);
+			destroy(slot);
+		}
+	}
+
+	unsigned int capacity() const { return (unsigned int) generations.size(); };
+	unsigned int retiredCount() const { return (unsigned int) retired.size(); };
+};
+
+// One slab per cell type, owned by a World
+struct CellPools {
+	CellSlab<PlayerCell, PLAYER> players;
+	CellSlab<Pellet, PELLET> pellets;
+	CellSlab<Virus, VIRUS> viruses;
+	CellSlab<EjectedCell, EJECTED_CELL> ejected;
+	CellSlab<MotherCell, MOTHER_CELL> motherCells;
+
+	Cell* get(CellHandle handle) {
+		switch (handleType(handle)) {
+			case PLAYER: return players.get(handle);
+			case PELLET: return pellets.get(handle);
+			case VIRUS: return viruses.get(handle);
+			case EJECTED_CELL: return ejected.get(handle);
+			case MOTHER_CELL: return motherCells.get(handle);
+			default: return nullptr;
+		}
+	}
+
+	void retire(Cell* cell, unsigned long tick) {
+		switch (cell->getType()) {
+			case PLAYER: players.retire(static_cast<PlayerCell*>(cell), tick); break;
+			case PELLET: pellets.retire(static_cast<Pellet*>(cell), tick); break;
+			case VIRUS: viruses.retire(static_cast<Virus*>(cell), tick); break;
+			case EJECTED_CELL: ejected.retire(static_cast<EjectedCell*>(cell), tick); break;
+			case MOTHER_CELL: motherCells.retire(static_cast<MotherCell*>(cell), tick); break;
+		}
+	}
+
+	void release(unsigned long tick) {
+		players.release(tick);
+		pellets.release(tick);
+		viruses.release(tick);
+		ejected.release(tick);
+		motherCells.release(tick);
+	}
+
+	void clear() {
+		players.clear();
+		pellets.clear();
+		viruses.clear();
+		ejected.clear();
+		motherCells.clear();
+	}
+};
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "Cell.h"
+#include "../worlds/Player.h"
+
+// What a cell does to another it touches, as a table over both types. Most pairs are settled by
+// the table alone, the rest name a rule that compares sizes, ages and owners. Everything is
+// inline so the collision pass classifies pairs without a virtual call.
+
+enum class Interaction : unsigned char {
+	NONE,
+	COLLIDE,
+	EATINVD,
+	PLAYER_PLAYER, // merging, collisions within a player or team, otherwise the bigger eats
+	PLAYER_PELLET, // owned cells eat pellets
+	PLAYER_MOTHER, // a mother cell much bigger than the player cell eats it, otherwise the bigger eats
+	PLAYER_OTHER,  // the bigger eats
+	VIRUS_FEED,    // viruses eat ejected mass until there are virusMaxCount of them
+	FEED_VIRUS     // and the same seen from the ejected cell
+};
+
+// Rows are the cell asking, columns the cell it touches, both in CellType order
+constexpr Interaction INTERACTIONS[5][5] = {
+	// PLAYER
+	{ Interaction::PLAYER_PLAYER, Interaction::PLAYER_PELLET, Interaction::PLAYER_OTHER, Interaction::PLAYER_OTHER, Interaction::PLAYER_MOTHER },
+	// PELLET
+	{ Interaction::NONE, Interaction::NONE, Interaction::NONE, Interaction::NONE, Interaction::NONE },
+	// VIRUS
+	{ Interaction::NONE, Interaction::NONE, Interaction::NONE, Interaction::VIRUS_FEED, Interaction::EATINVD },
+	// EJECTED_CELL
+	{ Interaction::NONE, Interaction::NONE, Interaction::FEED_VIRUS, Interaction::COLLIDE, Interaction::EATINVD },
+	// MOTHER_CELL
+	{ Interaction::NONE, Interaction::NONE, Interaction::NONE, Interaction::NONE, Interaction::NONE }
+};
+
+// Kinds a cell of type does something to when it is the one asking, as a finder kind mask
+constexpr unsigned char interactionKinds(CellType type) {
+	unsigned char kinds = 0;
+	for (unsigned int other = 0; other < 5; other++)
+		if (INTERACTIONS[type][other] != Interaction::NONE) kinds |= 1 << other;
+	return kinds;
+}
+
+// Runtime settings and world state the rules read, taken once per tick by World::getInteractionParams
+struct InteractionParams {
+	unsigned long tick = 0;
+	int stepMult = 1;
+	float noCollideDelay = 0;
+	float eatMult = 1;
+	int spawnProtection = 0;
+	bool virusFull = false;
+};
+
+// Same as Cell::getAge
+inline unsigned long interactionAge(const InteractionParams& params, Cell* cell) {
+	return (params.tick - cell->birthTick) * params.stepMult;
+}
+
+inline EatResult sizeEatResult(const InteractionParams& params, Cell* cell, Cell* other) {
+	if (params.tick - cell->owner->joinTick < params.spawnProtection && other->owner != cell->owner) return EatResult::NONE;
+	return other->getSize() * params.eatMult > cell->getSize() ? EatResult::NONE : EatResult::EAT;
+}
+
+inline EatResult playerEatResult(const InteractionParams& params, Cell* cell, Cell* other) {
+	if (!cell->owner && !other->owner) return EatResult::COLLIDE;
+	if (!cell->owner) return EatResult::NONE;
+	auto delay = params.noCollideDelay;
+	if (other->owner && other->owner->id == cell->owner->id) {
+		if (interactionAge(params, other) < delay || interactionAge(params, cell) < delay) return EatResult::NONE;
+		if (((PlayerCell*) cell)->canMerge() && ((PlayerCell*) other)->canMerge()) return EatResult::EAT;
+		return EatResult::COLLIDE;
+	}
+	if (other->owner && cell->owner->team >= 0 && other->owner->team == cell->owner->team)
+		return (interactionAge(params, other) < delay || interactionAge(params, cell) < delay) ? EatResult::NONE : EatResult::COLLIDE;
+	return sizeEatResult(params, cell, other);
+}
+
+inline EatResult getEatResult(const InteractionParams& params, Cell* cell, Cell* other) {
+	switch (INTERACTIONS[cell->getType()][other->getType()]) {
+		case Interaction::COLLIDE: return EatResult::COLLIDE;
+		case Interaction::EATINVD: return EatResult::EATINVD;
+		case Interaction::PLAYER_PLAYER: return playerEatResult(params, cell, other);
+		case Interaction::PLAYER_PELLET: return cell->owner ? EatResult::EAT : EatResult::NONE;
+		case Interaction::PLAYER_MOTHER:
+			if (!cell->owner) return EatResult::NONE;
+			if (other->getSize() > cell->getSize() * params.eatMult) return EatResult::EATINVD;
+			return sizeEatResult(params, cell, other);
+		case Interaction::PLAYER_OTHER:
+			if (!cell->owner) return EatResult::NONE;
+			return sizeEatResult(params, cell, other);
+		case Interaction::VIRUS_FEED: return params.virusFull ? EatResult::NONE : EatResult::EAT;
+		case Interaction::FEED_VIRUS: return params.virusFull ? EatResult::NONE : EatResult::EATINVD;
+		default: return EatResult::NONE;
+	}
+}
@@ -9,6 +9,7 @@
 #include "../protocols/Protocol6.h"
 #include "../protocols/ProtocolVanis.h"
 #include "../gamemodes/FFA.h"
+#include "../bench/Benchmark.h"
 
 void registerGamemodes(ServerHandle* handle) {
 	auto ffa = new FFA(handle);
@@ -66,6 +67,12 @@ void registerCommands(ServerHandle* handle) {
 	});
 	handle->commands.registerCommand(benchCommand);
 
+	Command<ServerHandle*> benchmarkCommand("benchmark", "run an offline benchmark suite (blocks the server)", "<suite> [args]",
+		[](ServerHandle* handle, auto context, vector<string>& args) {
+		runBenchmark(handle, args);
+	});
+	handle->commands.registerCommand(benchmarkCommand);
+
 	Command<ServerHandle*> monitorStartCommand("mstart", "monitor load and cell count", "",
 		[](ServerHandle* handle, auto context, vector<string>& args) {
 		handle->bytesSent = 0;
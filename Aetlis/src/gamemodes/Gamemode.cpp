@@ -18,6 +18,7 @@ void Gamemode::onPlayerEject(Player* player) {
 	player->world->ejectFromPlayer(player);
 }
 
+// Player cell kernels apply the same decay, see integratePlayerCellsScalar
 float Gamemode::getDecayMult(Cell* cell) {
 	float baseMult = cell->world->handle->runtime.playerDecayMult;
 	
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <utility>
+#include "Rect.h"
+
+// Index sentinel for "no node" in a finder's storage
+static const unsigned int QUAD_NONE = 0xFFFFFFFF;
+// Item kinds a filtered query can select, as a bitmask of 1 << kind
+static const unsigned int QUAD_KINDS = 8;
+static const unsigned char QUAD_ANY = 0xFF;
+
+class QuadItem : public Point {
+public:
+	unsigned int node; // owning node/bucket in the finder, QUAD_NONE if not inserted
+	unsigned int slot; // position inside the owning node's item array
+	unsigned char kind; // below QUAD_KINDS, set before inserting
+	Rect range;
+	QuadItem(const float x, const float y) : Point(x, y), node(QUAD_NONE), slot(0), kind(0) {};
+};
+
+static inline float centerDistSq(const Point& p, const QuadItem* item) {
+	float dx = item->range.getX() - p.getX();
+	float dy = item->range.getY() - p.getY();
+	return dx * dx + dy * dy;
+}
+
+// Items are treated as the circle inscribed in their range
+static inline bool circleOverlaps(const CircleBorder& circle, const QuadItem* item) {
+	float dx = item->range.getX() - circle.getX();
+	float dy = item->range.getY() - circle.getY();
+	float reach = item->range.w + circle.getRadius();
+	return dx * dx + dy * dy < reach * reach;
+}
+
+// Ranking for finders without a hierarchy: sorts what was gathered past base by key and
+// hands it out until k are accepted (0 for no limit), then drops it
+typedef std::pair<float, QuadItem*> RankedItem;
+template<typename F>
+unsigned int emitRanked(std::vector<RankedItem>& ranked, size_t base, unsigned int k, F& callback) {
+	std::sort(ranked.begin() + base, ranked.end(),
+		[](const RankedItem& a, const RankedItem& b) { return a.first < b.first; });
+	unsigned int count = 0;
+	for (auto i = base; i < ranked.size(); i++)
+		if (callback(ranked[i].second) && ++count == k) break;
+	ranked.resize(base);
+	return count;
+}
+
+enum class FinderType : unsigned char {
+	QUADTREE,
+	GRID,
+	SWEEP
+};
+
+// Broad phase shared by every spatial index. Mutations are virtual, while the
+// templated queries switch on type (see Finders.h) so callbacks still inline.
+class Finder {
+public:
+	const FinderType type;
+	unsigned int maxSearch = 0;
+
+	Finder(FinderType type) : type(type) {};
+	virtual ~Finder() {};
+	virtual void insert(QuadItem* item) = 0;
+	virtual void update(QuadItem* item) = 0;
+	virtual void remove(QuadItem* item) = 0;
+
+	template<typename F>
+	unsigned int search(const Rect& rect, F&& callback);
+	template<typename F>
+	bool containAny(const Rect& rect, F&& selector);
+	// Filtered variants only visit items whose kind is set in kinds
+	template<typename F>
+	unsigned int search(const Rect& rect, unsigned char kinds, F&& callback);
+	template<typename F>
+	bool containAny(const Rect& rect, unsigned char kinds, F&& selector);
+	template<typename F>
+	unsigned int searchBatch(const Rect* ranges, unsigned int count, F&& callback);
+	// Same, but against circles: only items whose inscribed circle overlaps one are reported
+	template<typename F>
+	unsigned int searchBatch(const CircleBorder* circles, unsigned int count, F&& callback);
+	// Items of kinds whose center lies within radius of p, nearest or largest first. callback(item)
+	// returns whether the item counts toward k (0 for no limit), the query stops once k have.
+	// A search capped by maxSearch is ranked the same way, nearest to the middle of rect first.
+	template<typename F>
+	unsigned int nearest(const Point& p, float radius, unsigned int k, unsigned char kinds, F&& callback);
+	template<typename F>
+	unsigned int largest(const Point& p, float radius, unsigned int k, unsigned char kinds, F&& callback);
+};
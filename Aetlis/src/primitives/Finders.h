@@ -0,0 +1,80 @@
+#pragma once
+
+#include "Finder.h"
+#include "QuadTree.h"
+#include "HashGrid.h"
+#include "SweepAndPrune.h"
+
+// Query dispatch for Finder, kept apart from Finder.h since it needs every backend
+
+template<typename F>
+unsigned int Finder::search(const Rect& rect, F&& callback) {
+	switch (type) {
+		case FinderType::GRID: return static_cast<HashGrid*>(this)->search(rect, callback);
+		case FinderType::SWEEP: return static_cast<SweepAndPrune*>(this)->search(rect, callback);
+		default: return static_cast<QuadTree*>(this)->search(rect, callback);
+	}
+}
+
+template<typename F>
+bool Finder::containAny(const Rect& rect, F&& selector) {
+	switch (type) {
+		case FinderType::GRID: return static_cast<HashGrid*>(this)->containAny(rect, selector);
+		case FinderType::SWEEP: return static_cast<SweepAndPrune*>(this)->containAny(rect, selector);
+		default: return static_cast<QuadTree*>(this)->containAny(rect, selector);
+	}
+}
+
+template<typename F>
+unsigned int Finder::search(const Rect& rect, unsigned char kinds, F&& callback) {
+	switch (type) {
+		case FinderType::GRID: return static_cast<HashGrid*>(this)->search(rect, kinds, callback);
+		case FinderType::SWEEP: return static_cast<SweepAndPrune*>(this)->search(rect, kinds, callback);
+		default: return static_cast<QuadTree*>(this)->search(rect, kinds, callback);
+	}
+}
+
+template<typename F>
+bool Finder::containAny(const Rect& rect, unsigned char kinds, F&& selector) {
+	switch (type) {
+		case FinderType::GRID: return static_cast<HashGrid*>(this)->containAny(rect, kinds, selector);
+		case FinderType::SWEEP: return static_cast<SweepAndPrune*>(this)->containAny(rect, kinds, selector);
+		default: return static_cast<QuadTree*>(this)->containAny(rect, kinds, selector);
+	}
+}
+
+template<typename F>
+unsigned int Finder::searchBatch(const Rect* ranges, unsigned int count, F&& callback) {
+	switch (type) {
+		case FinderType::GRID: return static_cast<HashGrid*>(this)->searchBatch(ranges, count, callback);
+		case FinderType::SWEEP: return static_cast<SweepAndPrune*>(this)->searchBatch(ranges, count, callback);
+		default: return static_cast<QuadTree*>(this)->searchBatch(ranges, count, callback);
+	}
+}
+
+template<typename F>
+unsigned int Finder::searchBatch(const CircleBorder* circles, unsigned int count, F&& callback) {
+	switch (type) {
+		case FinderType::GRID: return static_cast<HashGrid*>(this)->searchBatch(circles, count, callback);
+		case FinderType::SWEEP: return static_cast<SweepAndPrune*>(this)->searchBatch(circles, count, callback);
+		default: return static_cast<QuadTree*>(this)->searchBatch(circles, count, callback);
+	}
+}
+
+template<typename F>
+unsigned int Finder::nearest(const Point& p, float radius, unsigned int k, unsigned char kinds, F&& callback) {
+	switch (type) {
+		case FinderType::GRID: return static_cast<HashGrid*>(this)->nearest(p, radius, k, kinds, callback);
+		case FinderType::SWEEP: return static_cast<SweepAndPrune*>(this)->nearest(p, radius, k, kinds, callback);
+		default: return static_cast<QuadTree*>(this)->nearest(p, radius, k, kinds, callback);
+	}
+}
+
+template<typename F>
+unsigned int Finder::largest(const Point& p, float radius, unsigned int k, unsigned char kinds, F&& callback) {
+	switch (type) {
+		case FinderType::GRID: return static_cast<HashGrid*>(this)->largest(p, radius, k, kinds, callback);
+		case FinderType::SWEEP: return static_cast<SweepAndPrune*>(this)->largest(p, radius, k, kinds, callback);
+		default: return static_cast<QuadTree*>(this)->largest(p, radius, k, kinds, callback);
+	}
+}
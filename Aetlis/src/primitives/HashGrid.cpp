@@ -0,0 +1,48 @@
+#include "HashGrid.h"
+
+#include <cmath>
+
+HashGrid::HashGrid(Rect& range, float cellSize) :
+	Finder(FinderType::GRID), range(range), cellSize(std::max(cellSize, 1.0f)) {
+	cols = std::max(1, (int) std::ceil(2 * range.w / this->cellSize));
+	rows = std::max(1, (int) std::ceil(2 * range.h / this->cellSize));
+	buckets.resize(cols * rows + 1);
+}
+
+unsigned int HashGrid::bucketFor(QuadItem* item) const {
+	if (item->range.w > cellSize / 2 || item->range.h > cellSize / 2) return largeBucket();
+	return row(item->range.getY()) * cols + column(item->range.getX());
+}
+
+void HashGrid::attach(unsigned int bucket, QuadItem* item) {
+	auto& items = buckets[bucket];
+	item->node = bucket;
+	item->slot = items.size();
+	items.push_back(item);
+}
+
+void HashGrid::detach(QuadItem* item) {
+	auto& items = buckets[item->node];
+	auto last = items.back();
+	items[item->slot] = last;
+	last->slot = item->slot;
+	items.pop_back();
+	item->node = QUAD_NONE;
+}
+
+void HashGrid::insert(QuadItem* item) {
+	attach(bucketFor(item), item);
+}
+
+void HashGrid::update(QuadItem* item) {
+	if (item->node == QUAD_NONE) return;
+	auto bucket = bucketFor(item);
+	if (bucket == item->node) return;
+	detach(item);
+	attach(bucket, item);
+}
+
+void HashGrid::remove(QuadItem* item) {
+	if (item->node == QUAD_NONE) return;
+	detach(item);
+}
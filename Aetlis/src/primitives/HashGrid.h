@@ -0,0 +1,169 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include "Rect.h"
+#include "Finder.h"
+
+// Uniform grid over the world border. The border is fixed, so buckets are indexed
+// directly by cell coordinates instead of hashing. Items go in the bucket holding
+// their center; items wider than half a cell live in one shared "large" bucket
+// that every query scans, which suits pellets/ejected mass next to few big players.
+class HashGrid : public Finder {
+public:
+	Rect range;
+	float cellSize;
+	unsigned int cols;
+	unsigned int rows;
+	// cols * rows grid buckets, followed by the large bucket
+	std::vector<std::vector<QuadItem*>> buckets;
+
+	HashGrid(Rect& range, float cellSize);
+	void insert(QuadItem* item) override;
+	void update(QuadItem* item) override;
+	void remove(QuadItem* item) override;
+
+	template<typename F>
+	unsigned int search(const Rect& rect, F&& callback);
+	template<typename F>
+	bool containAny(const Rect& rect, F&& selector);
+	template<typename F>
+	unsigned int search(const Rect& rect, unsigned char kinds, F&& callback);
+	template<typename F>
+	bool containAny(const Rect& rect, unsigned char kinds, F&& selector);
+	template<typename F>
+	unsigned int searchBatch(const Rect* ranges, unsigned int count, F&& callback);
+	template<typename F>
+	unsigned int searchBatch(const CircleBorder* circles, unsigned int count, F&& callback);
+	template<typename F>
+	unsigned int nearest(const Point& p, float radius, unsigned int k, unsigned char kinds, F&& callback);
+	template<typename F>
+	unsigned int largest(const Point& p, float radius, unsigned int k, unsigned char kinds, F&& callback);
+private:
+	unsigned int largeBucket() const { return cols * rows; };
+	unsigned int column(float x) const;
+	unsigned int row(float y) const;
+	unsigned int bucketFor(QuadItem* item) const;
+	void attach(unsigned int bucket, QuadItem* item);
+	void detach(QuadItem* item);
+	// Calls visitor on every item intersecting rect until it returns true
+	template<typename F>
+	bool visit(const Rect& rect, F&& visitor);
+};
+
+inline unsigned int HashGrid::column(float x) const {
+	float c = (x - range.getX() + range.w) / cellSize;
+	return c <= 0 ? 0 : std::min((unsigned int) c, cols - 1);
+}
+
+inline unsigned int HashGrid::row(float y) const {
+	float r = (y - range.getY() + range.h) / cellSize;
+	return r <= 0 ? 0 : std::min((unsigned int) r, rows - 1);
+}
+
+template<typename F>
+bool HashGrid::visit(const Rect& rect, F&& visitor) {
+	for (auto item : buckets[largeBucket()])
+		if (rect.intersects(item->range) && visitor(item)) return true;
+
+	// Small items reach at most half a cell past their bucket
+	float pad = cellSize / 2;
+	unsigned int c0 = column(rect.getX() - rect.w - pad), c1 = column(rect.getX() + rect.w + pad);
+	unsigned int r0 = row(rect.getY() - rect.h - pad), r1 = row(rect.getY() + rect.h + pad);
+	for (unsigned int r = r0; r <= r1; r++) {
+		for (unsigned int c = c0; c <= c1; c++) {
+			for (auto item : buckets[r * cols + c])
+				if (rect.intersects(item->range) && visitor(item)) return true;
+		}
+	}
+	return false;
+}
+
+template<typename F>
+unsigned int HashGrid::search(const Rect& rect, F&& callback) {
+	return search(rect, QUAD_ANY, callback);
+}
+
+template<typename F>
+bool HashGrid::containAny(const Rect& rect, F&& selector) {
+	return visit(rect, selector);
+}
+
+template<typename F>
+unsigned int HashGrid::search(const Rect& rect, unsigned char kinds, F&& callback) {
+	unsigned int count = 0;
+	if (!maxSearch) {
+		visit(rect, [kinds, &count, &callback](QuadItem* item) {
+			if (!(kinds & (1 << item->kind))) return false;
+			callback(item);
+			count++;
+			return false;
+		});
+		return count;
+	}
+
+	// Capped, so keep the items nearest to the middle of rect rather than the first ones reached
+	static thread_local std::vector<RankedItem> ranked;
+	auto base = ranked.size();
+	Point center(rect.getX(), rect.getY());
+	visit(rect, [kinds, &center](QuadItem* item) {
+		if (kinds & (1 << item->kind)) ranked.push_back(std::make_pair(centerDistSq(center, item), item));
+		return false;
+	});
+	return emitRanked(ranked, base, maxSearch, callback);
+}
+
+template<typename F>
+bool HashGrid::containAny(const Rect& rect, unsigned char kinds, F&& selector) {
+	return visit(rect, [kinds, &selector](QuadItem* item) { return (kinds & (1 << item->kind)) && selector(item); });
+}
+
+template<typename F>
+unsigned int HashGrid::nearest(const Point& p, float radius, unsigned int k, unsigned char kinds, F&& callback) {
+	static thread_local std::vector<RankedItem> ranked;
+	auto base = ranked.size();
+	float limit = radius * radius;
+	visit(Rect(p.getX(), p.getY(), radius, radius), [&p, kinds, limit](QuadItem* item) {
+		float dSq = centerDistSq(p, item);
+		if ((kinds & (1 << item->kind)) && dSq <= limit) ranked.push_back(std::make_pair(dSq, item));
+		return false;
+	});
+	return emitRanked(ranked, base, k, callback);
+}
+
+template<typename F>
+unsigned int HashGrid::largest(const Point& p, float radius, unsigned int k, unsigned char kinds, F&& callback) {
+	static thread_local std::vector<RankedItem> ranked;
+	auto base = ranked.size();
+	float limit = radius * radius;
+	visit(Rect(p.getX(), p.getY(), radius, radius), [&p, kinds, limit](QuadItem* item) {
+		if ((kinds & (1 << item->kind)) && centerDistSq(p, item) <= limit)
+			ranked.push_back(std::make_pair(-item->range.w, item));
+		return false;
+	});
+	return emitRanked(ranked, base, k, callback);
+}
+
+template<typename F>
+unsigned int HashGrid::searchBatch(const Rect* ranges, unsigned int count, F&& callback) {
+	unsigned int visited = 0;
+	for (unsigned int q = 0; q < count; q++)
+		visited += search(ranges[q], [q, &callback](QuadItem* item) { return callback(q, item); });
+	return visited;
+}
+
+// Searches the bounding square of each circle and drops the corners
+template<typename F>
+unsigned int HashGrid::searchBatch(const CircleBorder* circles, unsigned int count, F&& callback) {
+	unsigned int visited = 0;
+	for (unsigned int q = 0; q < count; q++) {
+		auto& circle = circles[q];
+		Rect bounds(circle.getX(), circle.getY(), circle.getRadius(), circle.getRadius());
+		search(bounds, [q, &circle, &visited, &callback](QuadItem* item) {
+			if (!circleOverlaps(circle, item)) return false;
+			visited++;
+			return callback(q, item);
+		});
+	}
+	return visited;
+}
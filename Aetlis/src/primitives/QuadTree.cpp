@@ -1,300 +1,348 @@
 #include "QuadTree.h"
 
-using std::list;
-
-class QuadNode {
-public:
-	unsigned int& maxLevel;
-	unsigned int& maxItem;
-	unsigned int level;
-	bool cleanup;
-
-	Rect range;
-	QuadNode* root;
-	QuadNode* branches;
-	list<QuadItem*> items;
-
-	QuadNode(Rect range, unsigned int& maxLevel, unsigned int& maxItem, QuadNode* root, bool cleanup = false) :
-		maxLevel(maxLevel), maxItem(maxItem), cleanup(cleanup), range(range), root(root), branches(nullptr) {
-		level = root ? root->level + 1 : 1;
+using std::vector;
+
+static inline unsigned int quadrantBranch(Quadrant quadrant) {
+	switch (quadrant) {
+		case QUAD_TL: return 0;
+		case QUAD_TR: return 1;
+		case QUAD_BL: return 2;
+		case QUAD_BR: return 3;
+		default: return QUAD_NONE;
 	}
+}
 
-	~QuadNode() {
-		if (cleanup)
-			for (auto item : items)
-				delete item;
-		if (!hasSplit()) return;
-		delete[] branches;
-		branches = nullptr;
+std::ostream& printNode(std::ostream& stream, QuadTree& tree, unsigned int index) {
+	auto& quad = tree.nodes[index];
+	stream << "items " << quad.items.size() << "/" << tree.maxItem << "/" << \
+		tree.getItemCount(index) << " level " << quad.level << " x " << quad.range.getX() << " y " << quad.range.getY() << \
+		" w " << quad.range.w << " h " << quad.range.h << std::endl;
+	if (quad.hasSplit()) {
+		for (unsigned int i = 0; i < 4; i++) {
+			stream << std::string(quad.level * 2, ' ');
+			printNode(stream, tree, tree.nodes[index].branches + i);
+		}
 	}
+	return stream;
+}
 
-	bool hasSplit() {
-		return branches != nullptr;
+std::ostream& operator<<(std::ostream& stream, QuadTree& tree) {
+	if (tree.nodes.size()) {
+		return printNode(stream, tree, 0);
+	}
+	else {
+		return stream << "[ROOTLESS TREE]" << std::endl;
 	}
+}
 
-	void insert(QuadItem* item) {
-		auto quad = this;
-		bool done = false;
-		while (!done) {
-			if (!quad->hasSplit()) break;
-			unsigned char quadrant = item->range.getQuadFullIntersect(quad->range);
-			switch (quadrant) {
-				case QUAD_TL:
-					quad = &branches[0]; break;
-				case QUAD_TR:
-					quad = &branches[1]; break;
-				case QUAD_BL:
-					quad = &branches[2]; break;
-				case QUAD_BR:
-					quad = &branches[3]; break;
-				default:
-					done = true;  break;
-			}
-		}
-		item->root = quad;
-		quad->items.push_back(item);
-		quad->split();
-	};
+QuadTree::QuadTree(Rect& range, unsigned int maxLevel, unsigned int maxItem, bool cleanup) :
+	Finder(FinderType::QUADTREE), maxLevel(maxLevel), maxItem(maxItem), cleanup(cleanup) {
+	nodes.reserve(1 + 4 * 64);
+	nodes.emplace_back(range, QUAD_NONE, 1);
 
-	void update(QuadItem* item) {
-		if (!item->root) return;
-		auto oldQuad = item->root;
-		auto newQuad = item->root;
-		while (true) {
-			if (!newQuad->root) break;
-			newQuad = newQuad->root;
-			if (newQuad->range.fullyIntersects(item->range)) break;
-		}
-		bool done = false;
-		while (!done) {
-			if (!newQuad->hasSplit()) break;
-			unsigned char quadrant = item->range.getQuadFullIntersect(newQuad->range);
-			switch (quadrant) {
-			case QUAD_TL:
-				newQuad = &branches[0]; break;
-			case QUAD_TR:
-				newQuad = &branches[1]; break;
-			case QUAD_BL:
-				newQuad = &branches[2]; break;
-			case QUAD_BR:
-				newQuad = &branches[3]; break;
-			default:
-				done = true;  break;
-			}
+	if (cleanup) {
+		if (cleanupQueue.size() > 5) {
+			delete cleanupQueue.front();
+			cleanupQueue.pop_front();
 		}
-		if (oldQuad == newQuad) return;
+		cleanupQueue.push_back(this);
+	}
+}
 
-		oldQuad->items.remove(item);
-		newQuad->items.push_back(item);
-		item->root = newQuad;
-		oldQuad->merge();
-		newQuad->split();
-	};
+QuadTree::~QuadTree() {
+	if (!cleanup) return;
+	for (auto& node : nodes)
+		for (auto item : node.items)
+			delete item;
+}
 
-	void remove(QuadItem* item) {
-		auto quad = item->root;
-		quad->items.remove(item);
-		item->root = nullptr;
-		quad->merge();
-	};
-	
-	void split() {
-		if (hasSplit() || (level > maxLevel) || (items.size() < maxItem)) return;
-		float x = range.getX();
-		float y = range.getY();
-		float hw = range.w / 2;
-		float hh = range.h / 2;
-		branches = new QuadNode[4]{
-			QuadNode(Rect(x - hw, y - hh, hw, hh), maxLevel, maxItem, this),
-			QuadNode(Rect(x + hw, y - hh, hw, hh), maxLevel, maxItem, this),
-			QuadNode(Rect(x - hw, y + hh, hw, hh), maxLevel, maxItem, this),
-			QuadNode(Rect(x + hw, y + hh, hw, hh), maxLevel, maxItem, this),
-		};
-		auto iter = items.begin();
-		while (iter != items.cend()) {
-			unsigned char quadrant = (*iter)->range.getQuadFullIntersect(range);
-			switch (quadrant) {
-				case QUAD_TL:
-					branches[0].insert(*iter); break;
-				case QUAD_TR:
-					branches[1].insert(*iter); break;
-				case QUAD_BL:
-					branches[2].insert(*iter); break;
-				case QUAD_BR:
-					branches[3].insert(*iter); break;
-				default:
-					iter++;
-					continue;
-			}
-			iter = items.erase(iter);
-		}
-	};
+// Branch of a split node that should own the item, QUAD_NONE if it stays in node
+unsigned int QuadTree::branchFor(unsigned int node, QuadItem* item) {
+	auto& range = nodes[node].range;
+	if (looseness <= 1.0f)
+		return quadrantBranch(item->range.getQuadFullIntersect(range));
+	// Loose branches overlap, so pick by center and keep it only if the loose bounds fit
+	unsigned int branch = (item->range.getY() < range.getY() ? 0 : 2) + (item->range.getX() < range.getX() ? 0 : 1);
+	return getLooseRange(nodes[node].branches + branch).fullyIntersects(item->range) ? branch : QUAD_NONE;
+}
 
-	void merge() {
-		auto quad = this;
-		while (quad) {
-			if (!quad->hasSplit()) {
-				quad = quad->root;
-				continue;
-			}
-			for (int i = 0; i < 4; i++)
-				if (quad->branches[i].hasSplit() || quad->branches[i].items.size() > 0)
-					return;
-			delete[] quad->branches;
-			quad->branches = nullptr;
-		}
+// Walks down from node to the deepest existing branch that fully contains the item
+unsigned int QuadTree::descend(unsigned int node, QuadItem* item) {
+	while (nodes[node].hasSplit()) {
+		unsigned int branch = branchFor(node, item);
+		if (branch == QUAD_NONE) break;
+		node = nodes[node].branches + branch;
 	}
+	return node;
+}
 
-	unsigned int getItemCount() {
-		if (!hasSplit()) return items.size();
-		return items.size() +
-			branches[0].getItemCount() + \
-			branches[1].getItemCount() + \
-			branches[2].getItemCount() + \
-			branches[3].getItemCount();
-	};
+// Adjusts the kind count of node and every ancestor
+void QuadTree::countKind(unsigned int node, unsigned char kind, int delta) {
+	unsigned char bit = 1 << kind;
+	for (; node != QUAD_NONE; node = nodes[node].parent) {
+		auto& quad = nodes[node];
+		quad.kindCounts[kind] += delta;
+		if (quad.kindCounts[kind]) quad.kinds |= bit;
+		else quad.kinds &= ~bit;
+	}
+}
 
-	int getBranchCount() {
-		if (hasSplit()) {
-			return 1 + \
-				branches[0].getBranchCount() + branches[1].getBranchCount() + \
-				branches[2].getBranchCount() + branches[3].getBranchCount();
-		}
-		return 1;
-	};
-	
-	unsigned int searchDFS(Rect& r, function<void(QuadItem*)> callback) {
-		unsigned int count = 0;
-		for (auto item : items) {
-			if (r.intersects(item->range)) {
-				callback(item);
-				count++;
-			}
-		}
-		if (!hasSplit()) return count;
-		auto quad = r.getQuadIntersect(range);
-		switch (quad) {
-			case QUAD_TL:
-				count += branches[0].searchDFS(r, callback); break;
-			case QUAD_TR:
-				count += branches[1].searchDFS(r, callback); break;
-			case QUAD_BL:
-				count += branches[2].searchDFS(r, callback); break;
-			case QUAD_BR:
-				count += branches[3].searchDFS(r, callback);
-			default:
-				break;
-		}
-		return count;
-	};
+void QuadTree::attach(unsigned int node, QuadItem* item) {
+	auto& items = nodes[node].items;
+	item->node = node;
+	item->slot = items.size();
+	items.push_back(item);
+	nodes[node].itemX.push_back(item->range.getX());
+	nodes[node].itemY.push_back(item->range.getY());
+	nodes[node].itemR.push_back(item->range.w);
+	countKind(node, item->kind, 1);
+}
 
-	unsigned int searchBFS(Rect& r, function<bool(QuadItem*)> callback) {
-		unsigned int count = 0;
-		for (auto item : items) {
-			if (r.intersects(item->range)) {
-				if (callback(item)) count++;
-			}
-		}
-		return count;
+void QuadTree::syncShape(QuadItem* item) {
+	auto& quad = nodes[item->node];
+	quad.itemX[item->slot] = item->range.getX();
+	quad.itemY[item->slot] = item->range.getY();
+	quad.itemR[item->slot] = item->range.w;
+}
+
+// O(1) swap-remove using the slot index kept on the item
+void QuadTree::detach(QuadItem* item) {
+	auto& quad = nodes[item->node];
+	auto& items = quad.items;
+	auto last = items.back();
+	items[item->slot] = last;
+	quad.itemX[item->slot] = quad.itemX.back();
+	quad.itemY[item->slot] = quad.itemY.back();
+	quad.itemR[item->slot] = quad.itemR.back();
+	last->slot = item->slot;
+	items.pop_back();
+	quad.itemX.pop_back();
+	quad.itemY.pop_back();
+	quad.itemR.pop_back();
+	countKind(item->node, item->kind, -1);
+	item->node = QUAD_NONE;
+}
+
+// Gives node 4 fresh branches, reusing a freed block when there is one
+unsigned int QuadTree::allocBranches(unsigned int node) {
+	unsigned int branches;
+	if (freeBranches.size()) {
+		branches = freeBranches.back();
+		freeBranches.pop_back();
+	} else {
+		branches = nodes.size();
+		for (int i = 0; i < 4; i++)
+			nodes.emplace_back(Rect(), QUAD_NONE, 0);
 	}
 
-	
-	bool containAny(Rect& r, function<bool(QuadItem*)> selector) {
-		for (auto item : items)
-			if (r.intersects(item->range) && selector(item)) return true;
-	
-		if (!hasSplit()) return false;
-		auto quad = r.getQuadIntersect(range);
-		switch (quad) {
-			case QUAD_TL:
-				if (branches[0].containAny(r, selector)) return true; break;
-			case QUAD_TR:
-				if (branches[1].containAny(r, selector)) return true; break;
-			case QUAD_BL:
-				if (branches[2].containAny(r, selector)) return true; break;
-			case QUAD_BR:
-				if (branches[3].containAny(r, selector)) return true; break;
-			default:
-				break;
-		}
-		return false;
+	float x = nodes[node].range.getX();
+	float y = nodes[node].range.getY();
+	float hw = nodes[node].range.w / 2;
+	float hh = nodes[node].range.h / 2;
+	Rect ranges[4] = {
+		Rect(x - hw, y - hh, hw, hh),
+		Rect(x + hw, y - hh, hw, hh),
+		Rect(x - hw, y + hh, hw, hh),
+		Rect(x + hw, y + hh, hw, hh)
 	};
-};
+	for (unsigned int i = 0; i < 4; i++) {
+		auto& branch = nodes[branches + i];
+		branch.range = ranges[i];
+		branch.parent = node;
+		branch.branches = QUAD_NONE;
+		branch.level = nodes[node].level + 1;
+		std::fill(branch.kindCounts, branch.kindCounts + QUAD_KINDS, 0);
+		branch.kinds = 0;
+	}
+	nodes[node].branches = branches;
+	return branches;
+}
 
-std::ostream& operator<<(std::ostream& stream, QuadNode& quad) {
-	stream << "items " << quad.items.size() << "/" << quad.maxItem << "/" << \
-		quad.getItemCount() << " level " << quad.level << " x " << quad.range.getX() << " y " << quad.range.getY() << \
-		" w " << quad.range.w << " h " << quad.range.h << std::endl;
-	if (quad.hasSplit()) {
-		for (int i = 0; i < 4; i++)
-			stream << std::string(quad.level * 2, ' ') << quad.branches[i];
+void QuadTree::splitNode(unsigned int node) {
+	if (nodes[node].hasSplit() || nodes[node].level > maxLevel || nodes[node].items.size() < maxItem) return;
+
+	unsigned int branches = allocBranches(node);
+	counters.splits++;
+
+	auto& items = nodes[node].items;
+	unsigned int i = 0;
+	while (i < items.size()) {
+		auto item = items[i];
+		unsigned int branch = branchFor(node, item);
+		if (branch == QUAD_NONE) {
+			i++;
+			continue;
+		}
+		detach(item);
+		attach(branches + branch, item);
 	}
-	return stream;
+	for (unsigned int b = 0; b < 4; b++)
+		splitNode(branches + b);
 }
 
-std::ostream& operator<<(std::ostream& stream, QuadTree& tree) {
-	if (tree.root) {
-		return stream << *tree.root;
+// Frees the branches of a split node once they are all empty leaves
+bool QuadTree::pruneBranches(unsigned int node) {
+	auto& quad = nodes[node];
+	for (unsigned int i = 0; i < 4; i++) {
+		auto& branch = nodes[quad.branches + i];
+		if (branch.hasSplit() || branch.items.size() > 0) return false;
 	}
-	else {
-		return stream << "[ROOTLESS TREE]" << std::endl;
+	freeBranches.push_back(quad.branches);
+	quad.branches = QUAD_NONE;
+	counters.merges++;
+	return true;
+}
+
+void QuadTree::mergeNode(unsigned int node) {
+	while (node != QUAD_NONE) {
+		if (nodes[node].hasSplit() && !pruneBranches(node)) return;
+		node = nodes[node].parent;
 	}
 }
 
-QuadTree::QuadTree(Rect& range, unsigned int maxLevel, unsigned int maxItem, bool cleanup) :
-	maxLevel(maxLevel), maxItem(maxItem) {
-	root = new QuadNode(range, this->maxLevel, this->maxItem, nullptr, cleanup);
+void QuadTree::insert(QuadItem* item, bool nosplit) {
+	if (nosplit) {
+		attach(0, item);
+		return;
+	}
+	unsigned int node = descend(0, item);
+	attach(node, item);
+	splitNode(node);
+};
 
-	if (cleanup) {
-		if (cleanupQueue.size() > 5) {
-			delete cleanupQueue.front();
-			cleanupQueue.pop_front();
-		}
-		cleanupQueue.push_back(this);
+void QuadTree::split() { splitNode(0); };
+
+void QuadTree::update(QuadItem* item) {
+	if (item->node == QUAD_NONE) return;
+	unsigned int oldNode = item->node;
+	unsigned int newNode = oldNode;
+	while (nodes[newNode].parent != QUAD_NONE && !getLooseRange(newNode).fullyIntersects(item->range))
+		newNode = nodes[newNode].parent;
+	newNode = descend(newNode, item);
+	if (oldNode == newNode) {
+		syncShape(item);
+		return;
 	}
-}
 
-QuadTree::~QuadTree() {
-	if (root) delete root;
+	counters.moves++;
+	detach(item);
+	attach(newNode, item);
+	mergeNode(oldNode);
+	splitNode(newNode);
+};
+
+// Update for an item that stays in its node: syncs its shape and returns true, otherwise
+// returns false and leaves the tree alone. Only reads the structure, so different items can
+// be refit from several threads at once.
+bool QuadTree::refit(QuadItem* item) {
+	if (item->node == QUAD_NONE) return true;
+	unsigned int node = item->node;
+	if (nodes[node].parent != QUAD_NONE && !getLooseRange(node).fullyIntersects(item->range)) return false;
+	if (descend(node, item) != node) return false;
+	syncShape(item);
+	return true;
 }
 
-void QuadTree::insert(QuadItem* item, bool nosplit) { 
-	if (root) nosplit ? root->items.push_back(item) : root->insert(item);
+void QuadTree::remove(QuadItem* item) {
+	if (item->node == QUAD_NONE) return;
+	unsigned int node = item->node;
+	detach(item);
+	mergeNode(node);
+};
+
+unsigned int QuadTree::getItemCount(unsigned int node) {
+	auto& quad = nodes[node];
+	if (!quad.hasSplit()) return quad.items.size();
+	return quad.items.size() +
+		getItemCount(quad.branches) + getItemCount(quad.branches + 1) + \
+		getItemCount(quad.branches + 2) + getItemCount(quad.branches + 3);
+};
+
+unsigned int QuadTree::getBranchCount(unsigned int node) {
+	auto& quad = nodes[node];
+	if (!quad.hasSplit()) return 1;
+	return 1 + \
+		getBranchCount(quad.branches) + getBranchCount(quad.branches + 1) + \
+		getBranchCount(quad.branches + 2) + getBranchCount(quad.branches + 3);
 };
-void QuadTree::split() { if (root) root->split(); };
-void QuadTree::update(QuadItem* item) { if (root) root->update(item); };
-void QuadTree::remove(QuadItem* item) { if (root) root->remove(item); };
-unsigned int QuadTree::search(Rect& rect, function<bool(QuadItem*)> callback) {
-	unsigned int count = 0;
-	if (root) {
-		if (maxSearch) {
-			list<QuadNode*> queue;
-			queue.push_back(root);
-
-			while (!queue.empty()) {
-				auto node = queue.front();
-				count += node->searchBFS(rect, callback);
-				queue.pop_front();
-
-				if (count >= maxSearch) {
-					// printf("search capped: %u, max: %u\n", count, maxSearch);
-					break;
-				}
-
-				if (node->hasSplit()) {
-					queue.push_back(&node->branches[0]);
-					queue.push_back(&node->branches[1]);
-					queue.push_back(&node->branches[2]);
-					queue.push_back(&node->branches[3]);
-				}
-			}
+
+QuadShape QuadTree::getShape() const {
+	QuadShape shape;
+	vector<unsigned int> stack = { 0 };
+	while (stack.size()) {
+		auto& quad = nodes[stack.back()];
+		stack.pop_back();
+		unsigned int depth = quad.level - 1;
+		if (shape.depthItems.size() <= depth) shape.depthItems.resize(depth + 1);
+		shape.depthItems[depth] += quad.items.size();
+		shape.items += quad.items.size();
+		shape.nodes++;
+		if (quad.hasSplit()) {
+			for (unsigned int b = 0; b < 4; b++) stack.push_back(quad.branches + b);
 		} else {
-			count = root->searchDFS(rect, callback);
+			shape.leaves++;
+			shape.leafItems += quad.items.size();
+			shape.maxLeafItems = std::max(shape.maxLeafItems, (unsigned int) quad.items.size());
 		}
 	}
-	return count;
+	return shape;
+}
+
+unsigned int QuadTree::mortonCode(const QuadItem* item) const {
+	auto& range = nodes[0].range;
+	auto quantize = [](float v) -> unsigned int {
+		v *= 65536.0f;
+		return v <= 0 ? 0 : v >= 65535.0f ? 65535 : (unsigned int) v;
+	};
+	// Spread 16 bits so there is a zero bit between each of them
+	auto spread = [](unsigned int v) {
+		v = (v | (v << 8)) & 0x00FF00FF;
+		v = (v | (v << 4)) & 0x0F0F0F0F;
+		v = (v | (v << 2)) & 0x33333333;
+		v = (v | (v << 1)) & 0x55555555;
+		return v;
+	};
+	unsigned int x = quantize((item->range.getX() - range.getX() + range.w) / (2 * range.w));
+	unsigned int y = quantize((item->range.getY() - range.getY() + range.h) / (2 * range.h));
+	// y takes the higher bit so each 2 bit digit is a branch index (TL, TR, BL, BR)
+	return spread(x) | (spread(y) << 1);
+}
+
+void QuadTree::rebuild(vector<MortonItem>& sorted) {
+	nodes.erase(nodes.begin() + 1, nodes.end());
+	nodes[0].items.clear();
+	nodes[0].itemX.clear();
+	nodes[0].itemY.clear();
+	nodes[0].itemR.clear();
+	nodes[0].branches = QUAD_NONE;
+	std::fill(nodes[0].kindCounts, nodes[0].kindCounts + QUAD_KINDS, 0);
+	nodes[0].kinds = 0;
+	freeBranches.clear();
+	buildNode(0, sorted.data(), sorted.data() + sorted.size());
+}
+
+void QuadTree::buildNode(unsigned int node, MortonItem* begin, MortonItem* end) {
+	unsigned int depth = nodes[node].level - 1;
+	if ((unsigned int) (end - begin) < maxItem || nodes[node].level > maxLevel || depth >= 16) {
+		for (auto iter = begin; iter != end; iter++) attach(node, iter->second);
+		return;
+	}
+
+	unsigned int branches = allocBranches(node);
+
+	// Codes under this node share every digit above depth, so each branch is a contiguous run
+	unsigned int shift = 30 - 2 * depth;
+	unsigned long long prefix = begin->first & ~((1ULL << (shift + 2)) - 1);
+	MortonItem* bounds[5] = { begin, nullptr, nullptr, nullptr, end };
+	for (unsigned int b = 1; b < 4; b++)
+		bounds[b] = std::lower_bound(bounds[b - 1], end, (unsigned int) (prefix + ((unsigned long long) b << shift)),
+			[](const MortonItem& item, unsigned int code) { return item.first < code; });
+
+	for (unsigned int b = 0; b < 4; b++) {
+		// Items that do not fit inside the branch stay here
+		auto fit = std::stable_partition(bounds[b], bounds[b + 1],
+			[this, node, b](const MortonItem& item) { return branchFor(node, item.second) == b; });
+		for (auto iter = fit; iter != bounds[b + 1]; iter++) attach(node, iter->second);
+		buildNode(branches + b, bounds[b], fit);
+	}
 }
-bool QuadTree::containAny(Rect& rect, function<bool(QuadItem*)> selector) {
-	if (root) return root->containAny(rect, selector);
-	return false;
-};
@@ -5,39 +5,564 @@
 #include <atomic>
 #include <iostream>
 #include <list>
+#include <vector>
 #include <algorithm>
 #include <string>
+#include <utility>
+#include <limits>
+#include <cmath>
 #include "Rect.h"
+#include "Finder.h"
 
 using std::function;
 using std::atomic;
 
-class QuadNode;
-class QuadItem : public Point {
-public:
-	QuadNode* root;
+// Morton (Z-order) code of an item's center paired with the item, see QuadTree::rebuild
+typedef std::pair<unsigned int, QuadItem*> MortonItem;
+
+struct QuadNode {
 	Rect range;
-	QuadItem(const float x, const float y) : Point(x, y), root(nullptr) {};
+	unsigned int parent;
+	unsigned int branches; // first of 4 consecutive children (TL, TR, BL, BR) in the pool
+	unsigned int level;
+	std::vector<QuadItem*> items;
+	// Center and radius of items[i] kept alongside, so circle tests do not chase pointers
+	std::vector<float> itemX;
+	std::vector<float> itemY;
+	std::vector<float> itemR;
+	// Items of each kind in this node and below, kinds has a bit for every nonzero count
+	unsigned int kindCounts[QUAD_KINDS] = {};
+	unsigned char kinds = 0;
+
+	QuadNode(Rect range, unsigned int parent, unsigned int level) :
+		range(range), parent(parent), branches(QUAD_NONE), level(level) {};
+	bool hasSplit() const { return branches != QUAD_NONE; };
+};
+
+// Query and restructuring counters, cleared by whoever reads them (World does once per tick)
+struct QuadCounters {
+	atomic<unsigned int> queries = 0;
+	atomic<unsigned long> nodesVisited = 0; // a batch counts every range that enters a node
+	unsigned int splits = 0;
+	unsigned int merges = 0;
+	unsigned int moves = 0; // updates that changed node
+	void reset() {
+		queries = 0;
+		nodesVisited = 0;
+		splits = merges = moves = 0;
+	};
+};
+
+// Layout snapshot, see QuadTree::getShape
+struct QuadShape {
+	unsigned int nodes = 0;
+	unsigned int leaves = 0;
+	unsigned int items = 0;
+	unsigned int leafItems = 0;
+	unsigned int maxLeafItems = 0;
+	std::vector<unsigned int> depthItems; // items held at each depth, 0 is the root
+	float itemsPerLeaf() const { return leaves ? (float) leafItems / leaves : 0; };
 };
 
-class QuadTree {
+// Entry of a ranked traversal, either an item or a node standing in for its subtree
+struct QuadRank {
+	float key;
+	unsigned int node;
+	QuadItem* item;
+};
+
+class QuadTree : public Finder {
 	friend std::ostream& operator<<(std::ostream& stream, QuadTree& quad);
 public:
-	QuadNode* root;
+	// nodes[0] is the root; children are allocated in blocks of 4 and recycled
+	std::vector<QuadNode> nodes;
+	std::vector<unsigned int> freeBranches;
 	unsigned int maxLevel;
 	unsigned int maxItem;
-	unsigned int maxSearch = 0;
+	// Loose tree when > 1: a node owns everything within its bounds scaled by this factor,
+	// so moving items only change node once they really leave it. Set before inserting.
+	float looseness = 1.0f;
+	bool cleanup;
 	atomic<unsigned int> reference = 0;
+	QuadCounters counters;
 	QuadTree(Rect& range, unsigned int maxLevel, unsigned int maxItem, bool cleanup = false);
 	~QuadTree();
-	void insert(QuadItem*, bool nosplit = false);
+	void insert(QuadItem* item) override { insert(item, false); };
+	void insert(QuadItem* item, bool nosplit);
 	void split();
-	void update(QuadItem*);
-	void remove(QuadItem*);
-	unsigned int search(Rect&, function<bool(QuadItem*)> callback);
-	bool containAny(Rect&, function<bool(QuadItem*)> selector);
+	void update(QuadItem* item) override;
+	bool refit(QuadItem* item);
+	void remove(QuadItem* item) override;
+
+	// Visitors are templates so the callback is inlined into the traversal
+	template<typename F>
+	unsigned int search(const Rect& rect, F&& callback);
+	template<typename F>
+	bool containAny(const Rect& rect, F&& selector);
+	// Filtered by item kind, subtrees holding none of kinds are skipped whole
+	template<typename F>
+	unsigned int search(const Rect& rect, unsigned char kinds, F&& callback);
+	template<typename F>
+	bool containAny(const Rect& rect, unsigned char kinds, F&& selector);
+	// Answers count ranges in a single traversal, callback(index, item) with index into ranges
+	template<typename F>
+	unsigned int searchBatch(const Rect* ranges, unsigned int count, F&& callback);
+	template<typename F>
+	unsigned int searchBatch(const CircleBorder* circles, unsigned int count, F&& callback);
+	template<typename F>
+	unsigned int nearest(const Point& p, float radius, unsigned int k, unsigned char kinds, F&& callback);
+	template<typename F>
+	unsigned int largest(const Point& p, float radius, unsigned int k, unsigned char kinds, F&& callback);
+	// Takes out every subtree below the root that holds only kinds and lies fully inside circle.
+	// Items are already out of the tree when take(item) sees them, returning false puts one back.
+	template<typename F>
+	unsigned int consume(const CircleBorder& circle, unsigned char kinds, F&& take);
+	// Bulk load: drops every node and builds the tree from items sorted by mortonCode
+	unsigned int mortonCode(const QuadItem* item) const;
+	void rebuild(std::vector<MortonItem>& sorted);
+	unsigned int getItemCount(unsigned int node = 0);
+	unsigned int getBranchCount(unsigned int node = 0);
+	QuadShape getShape() const;
+private:
+	// Nodes entered by this thread's running query, added to counters when it returns
+	static inline thread_local unsigned int visits = 0;
+	void countQueries(unsigned int count) {
+		counters.queries += count;
+		counters.nodesVisited += visits;
+		visits = 0;
+	};
+	Rect getLooseRange(unsigned int node) const;
+	unsigned int branchFor(unsigned int node, QuadItem* item);
+	unsigned int branchMask(unsigned int node, const Rect& r);
+	unsigned int descend(unsigned int node, QuadItem* item);
+	void countKind(unsigned int node, unsigned char kind, int delta);
+	void attach(unsigned int node, QuadItem* item);
+	void detach(QuadItem* item);
+	void syncShape(QuadItem* item);
+	unsigned int allocBranches(unsigned int node);
+	void splitNode(unsigned int node);
+	void buildNode(unsigned int node, MortonItem* begin, MortonItem* end);
+	bool pruneBranches(unsigned int node);
+	void mergeNode(unsigned int node);
+	template<typename F>
+	unsigned int searchDFS(unsigned int node, const Rect& r, unsigned char kinds, F& callback);
+	template<typename F>
+	bool containAnyDFS(unsigned int node, const Rect& r, unsigned char kinds, F& selector);
+	template<typename F>
+	unsigned int searchBatchDFS(unsigned int node, const Rect* ranges, std::vector<unsigned int>& active,
+		std::vector<unsigned char>& masks, unsigned int begin, unsigned int end, F& callback);
+	template<typename F>
+	unsigned int circleBatchDFS(unsigned int node, const CircleBorder* circles, std::vector<unsigned int>& active,
+		std::vector<unsigned char>& masks, unsigned int begin, unsigned int end, F& callback);
+	// Best first walk handing out items by ascending key until k are accepted. itemKey(item, key)
+	// and nodeKey(node, key) return false to prune; a node's key may not exceed any key below it.
+	template<typename F>
+	unsigned int consumeDFS(unsigned int node, const CircleBorder& circle, unsigned char kinds, F& take);
+	template<typename F>
+	unsigned int takeSubtree(unsigned int node, F& take);
+	template<typename K, typename N, typename F>
+	unsigned int rankedSearch(unsigned char kinds, unsigned int k, K itemKey, N nodeKey, F& callback);
 };
 
+static const Quadrant QUAD_BRANCHES[4] = { QUAD_TL, QUAD_TR, QUAD_BL, QUAD_BR };
+
+// Squared distance from p to the closest point of r, 0 inside it
+static inline float rectDistSq(const Point& p, const Rect& r) {
+	float dx = std::max(std::abs(p.getX() - r.getX()) - r.w, 0.0f);
+	float dy = std::max(std::abs(p.getY() - r.getY()) - r.h, 0.0f);
+	return dx * dx + dy * dy;
+}
+
+// Squared distance from p to the farthest corner of r
+static inline float rectFarDistSq(const Point& p, const Rect& r) {
+	float dx = std::abs(p.getX() - r.getX()) + r.w;
+	float dy = std::abs(p.getY() - r.getY()) + r.h;
+	return dx * dx + dy * dy;
+}
+
+inline Rect QuadTree::getLooseRange(unsigned int node) const {
+	auto& range = nodes[node].range;
+	return Rect(range.getX(), range.getY(), range.w * looseness, range.h * looseness);
+}
+
+// Bit b set when branch b of a split node can hold items intersecting r
+inline unsigned int QuadTree::branchMask(unsigned int node, const Rect& r) {
+	unsigned int mask = 0;
+	if (looseness > 1.0f) {
+		auto branches = nodes[node].branches;
+		for (unsigned int b = 0; b < 4; b++)
+			if (r.intersects(getLooseRange(branches + b))) mask |= 1 << b;
+	} else {
+		auto sides = r.getQuadIntersect(nodes[node].range);
+		for (unsigned int b = 0; b < 4; b++)
+			if ((sides & QUAD_BRANCHES[b]) == QUAD_BRANCHES[b]) mask |= 1 << b;
+	}
+	return mask;
+}
+
+template<typename F>
+unsigned int QuadTree::searchDFS(unsigned int node, const Rect& r, unsigned char kinds, F& callback) {
+	unsigned int count = 0;
+	auto& quad = nodes[node];
+	visits++;
+	for (auto item : quad.items) {
+		if ((kinds & (1 << item->kind)) && r.intersects(item->range)) {
+			callback(item);
+			count++;
+		}
+	}
+	if (!quad.hasSplit()) return count;
+	auto mask = branchMask(node, r);
+	for (unsigned int b = 0; b < 4; b++)
+		if ((mask & (1 << b)) && (nodes[quad.branches + b].kinds & kinds))
+			count += searchDFS(quad.branches + b, r, kinds, callback);
+	return count;
+}
+
+template<typename F>
+bool QuadTree::containAnyDFS(unsigned int node, const Rect& r, unsigned char kinds, F& selector) {
+	auto& quad = nodes[node];
+	visits++;
+	for (auto item : quad.items)
+		if ((kinds & (1 << item->kind)) && r.intersects(item->range) && selector(item)) return true;
+
+	if (!quad.hasSplit()) return false;
+	auto mask = branchMask(node, r);
+	for (unsigned int b = 0; b < 4; b++)
+		if ((mask & (1 << b)) && (nodes[quad.branches + b].kinds & kinds) &&
+			containAnyDFS(quad.branches + b, r, kinds, selector)) return true;
+	return false;
+}
+
+template<typename F>
+unsigned int QuadTree::search(const Rect& rect, F&& callback) {
+	return search(rect, QUAD_ANY, callback);
+}
+
+template<typename F>
+unsigned int QuadTree::search(const Rect& rect, unsigned char kinds, F&& callback) {
+	if (!(nodes[0].kinds & kinds)) return 0;
+	if (!maxSearch) {
+		auto count = searchDFS(0, rect, kinds, callback);
+		countQueries(1);
+		return count;
+	}
+
+	// Capped, so keep the items nearest to the middle of rect rather than the first ones reached
+	Point center(rect.getX(), rect.getY());
+	return rankedSearch(kinds, maxSearch,
+		[&rect, &center](QuadItem* item, float& key) {
+			key = centerDistSq(center, item);
+			return rect.intersects(item->range);
+		},
+		[this, &rect, &center](unsigned int node, float& key) {
+			auto range = getLooseRange(node);
+			key = rectDistSq(center, range);
+			return rect.intersects(range);
+		}, callback);
+}
+
+template<typename F>
+bool QuadTree::containAny(const Rect& rect, F&& selector) {
+	return containAny(rect, QUAD_ANY, selector);
+}
+
+template<typename F>
+bool QuadTree::containAny(const Rect& rect, unsigned char kinds, F&& selector) {
+	if (!(nodes[0].kinds & kinds)) return false;
+	auto found = containAnyDFS(0, rect, kinds, selector);
+	countQueries(1);
+	return found;
+}
+
+template<typename K, typename N, typename F>
+unsigned int QuadTree::rankedSearch(unsigned char kinds, unsigned int k, K itemKey, N nodeKey, F& callback) {
+	// Min heap over [base, end), base keeps nested queries from clobbering each other
+	static thread_local std::vector<QuadRank> heap;
+	if (!(nodes[0].kinds & kinds)) return 0;
+	auto later = [](const QuadRank& a, const QuadRank& b) { return a.key > b.key; };
+	auto base = heap.size();
+	unsigned int count = 0;
+	float key;
+	heap.push_back({ std::numeric_limits<float>::lowest(), 0, nullptr });
+
+	while (heap.size() > base) {
+		std::pop_heap(heap.begin() + base, heap.end(), later);
+		auto top = heap.back();
+		heap.pop_back();
+		if (top.item) {
+			if (callback(top.item) && ++count == k) break;
+			continue;
+		}
+
+		auto& quad = nodes[top.node];
+		visits++;
+		for (auto item : quad.items) {
+			if (!(kinds & (1 << item->kind)) || !itemKey(item, key)) continue;
+			heap.push_back({ key, QUAD_NONE, item });
+			std::push_heap(heap.begin() + base, heap.end(), later);
+		}
+		if (!quad.hasSplit()) continue;
+		for (unsigned int b = 0; b < 4; b++) {
+			auto branch = quad.branches + b;
+			if (!(nodes[branch].kinds & kinds) || !nodeKey(branch, key)) continue;
+			heap.push_back({ key, branch, nullptr });
+			std::push_heap(heap.begin() + base, heap.end(), later);
+		}
+	}
+	heap.resize(base);
+	countQueries(1);
+	return count;
+}
+
+template<typename F>
+unsigned int QuadTree::nearest(const Point& p, float radius, unsigned int k, unsigned char kinds, F&& callback) {
+	float limit = radius * radius;
+	return rankedSearch(kinds, k,
+		[&p, limit](QuadItem* item, float& key) {
+			key = centerDistSq(p, item);
+			return key <= limit;
+		},
+		[this, &p, limit](unsigned int node, float& key) {
+			key = rectDistSq(p, getLooseRange(node));
+			return key <= limit;
+		}, callback);
+}
+
+template<typename F>
+unsigned int QuadTree::largest(const Point& p, float radius, unsigned int k, unsigned char kinds, F&& callback) {
+	float limit = radius * radius;
+	return rankedSearch(kinds, k,
+		[&p, limit](QuadItem* item, float& key) {
+			key = -item->range.w;
+			return centerDistSq(p, item) <= limit;
+		},
+		[this, &p, limit](unsigned int node, float& key) {
+			// Anything below fits the loose bounds, so it is no wider than them
+			key = -nodes[node].range.w * looseness;
+			return rectDistSq(p, getLooseRange(node)) <= limit;
+		}, callback);
+}
+
+template<typename F>
+unsigned int QuadTree::searchBatchDFS(unsigned int node, const Rect* ranges, std::vector<unsigned int>& active,
+	std::vector<unsigned char>& masks, unsigned int begin, unsigned int end, F& callback) {
+	unsigned int count = 0;
+	auto& quad = nodes[node];
+	visits += end - begin;
+	for (unsigned int i = begin; i < end; i++) {
+		auto q = active[i];
+		auto& r = ranges[q];
+		for (auto item : quad.items) {
+			if (!r.intersects(item->range)) continue;
+			callback(q, item);
+			count++;
+		}
+	}
+	if (!quad.hasSplit()) return count;
+
+	// Each branch gets the subset of active queries overlapping it, appended past end
+	if (masks.size() < end) masks.resize(end);
+	for (unsigned int i = begin; i < end; i++)
+		masks[i] = branchMask(node, ranges[active[i]]);
+	for (unsigned int b = 0; b < 4; b++) {
+		unsigned int childBegin = active.size();
+		for (unsigned int i = begin; i < end; i++)
+			if (masks[i] & (1 << b)) active.push_back(active[i]);
+		unsigned int childEnd = active.size();
+		if (childEnd > childBegin)
+			count += searchBatchDFS(quad.branches + b, ranges, active, masks, childBegin, childEnd, callback);
+		active.resize(childBegin);
+	}
+	return count;
+}
+
+// Same results as calling search once per range, but the tree is walked once for the whole batch.
+// Capped ranges rank their items, so with maxSearch set they are answered one by one.
+template<typename F>
+unsigned int QuadTree::searchBatch(const Rect* ranges, unsigned int count, F&& callback) {
+	static thread_local std::vector<unsigned int> active;
+	static thread_local std::vector<unsigned char> masks;
+	if (!count) return 0;
+	if (maxSearch) {
+		unsigned int visited = 0;
+		for (unsigned int q = 0; q < count; q++)
+			visited += search(ranges[q], [q, &callback](QuadItem* item) { return callback(q, item); });
+		return visited;
+	}
+	unsigned int base = active.size();
+	for (unsigned int q = 0; q < count; q++) active.push_back(q);
+	auto visited = searchBatchDFS(0, ranges, active, masks, base, base + count, callback);
+	active.resize(base);
+	countQueries(count);
+	return visited;
+}
+
+template<typename F>
+unsigned int QuadTree::circleBatchDFS(unsigned int node, const CircleBorder* circles, std::vector<unsigned int>& active,
+	std::vector<unsigned char>& masks, unsigned int begin, unsigned int end, F& callback) {
+	static thread_local std::vector<unsigned char> hits;
+	unsigned int count = 0;
+	auto& quad = nodes[node];
+	visits += end - begin;
+
+	unsigned int size = quad.items.size();
+	if (size) {
+		if (hits.size() < size) hits.resize(size);
+		const float* xs = quad.itemX.data();
+		const float* ys = quad.itemY.data();
+		const float* rs = quad.itemR.data();
+		unsigned char* hit = hits.data();
+		for (unsigned int i = begin; i < end; i++) {
+			auto q = active[i];
+			float cx = circles[q].getX(), cy = circles[q].getY(), cr = circles[q].getRadius();
+			// Branch free so the compiler can vectorise it, hits are handed out after
+			for (unsigned int j = 0; j < size; j++) {
+				float dx = xs[j] - cx, dy = ys[j] - cy, reach = rs[j] + cr;
+				hit[j] = dx * dx + dy * dy < reach * reach;
+			}
+			for (unsigned int j = 0; j < size; j++) {
+				if (!hit[j]) continue;
+				callback(q, quad.items[j]);
+				count++;
+			}
+		}
+	}
+	if (!quad.hasSplit()) return count;
+
+	// Every item below fits the branch's loose bounds, so the circle has to reach into them
+	if (masks.size() < end) masks.resize(end);
+	for (unsigned int i = begin; i < end; i++) {
+		auto& circle = circles[active[i]];
+		float limit = circle.getRadius() * circle.getRadius();
+		unsigned char mask = 0;
+		for (unsigned int b = 0; b < 4; b++)
+			if (rectDistSq(circle.center, getLooseRange(quad.branches + b)) < limit) mask |= 1 << b;
+		masks[i] = mask;
+	}
+	for (unsigned int b = 0; b < 4; b++) {
+		unsigned int childBegin = active.size();
+		for (unsigned int i = begin; i < end; i++)
+			if (masks[i] & (1 << b)) active.push_back(active[i]);
+		unsigned int childEnd = active.size();
+		if (childEnd > childBegin)
+			count += circleBatchDFS(quad.branches + b, circles, active, masks, childBegin, childEnd, callback);
+		active.resize(childBegin);
+	}
+	return count;
+}
+
+// Circle version of searchBatch, nodes and items are pruned by true distance instead of bounding squares
+template<typename F>
+unsigned int QuadTree::searchBatch(const CircleBorder* circles, unsigned int count, F&& callback) {
+	static thread_local std::vector<unsigned int> active;
+	static thread_local std::vector<unsigned char> masks;
+	if (!count) return 0;
+	if (maxSearch) {
+		unsigned int visited = 0;
+		for (unsigned int q = 0; q < count; q++) {
+			auto& circle = circles[q];
+			Rect bounds(circle.getX(), circle.getY(), circle.getRadius(), circle.getRadius());
+			search(bounds, [q, &circle, &visited, &callback](QuadItem* item) {
+				if (!circleOverlaps(circle, item)) return false;
+				visited++;
+				return callback(q, item);
+			});
+		}
+		return visited;
+	}
+	unsigned int base = active.size();
+	for (unsigned int q = 0; q < count; q++) active.push_back(q);
+	auto visited = circleBatchDFS(0, circles, active, masks, base, base + count, callback);
+	active.resize(base);
+	countQueries(count);
+	return visited;
+}
+
+// Empties node and everything below it except the items take refuses, counts are rebuilt on the way up
+template<typename F>
+unsigned int QuadTree::takeSubtree(unsigned int node, F& take) {
+	unsigned int count = 0;
+	auto& quad = nodes[node];
+	visits++;
+	unsigned int kept = 0;
+	for (unsigned int i = 0; i < quad.items.size(); i++) {
+		auto item = quad.items[i];
+		item->node = QUAD_NONE;
+		if (take(item)) {
+			count++;
+			continue;
+		}
+		item->node = node;
+		item->slot = kept;
+		quad.items[kept] = item;
+		quad.itemX[kept] = quad.itemX[i];
+		quad.itemY[kept] = quad.itemY[i];
+		quad.itemR[kept] = quad.itemR[i];
+		kept++;
+	}
+	quad.items.resize(kept);
+	quad.itemX.resize(kept);
+	quad.itemY.resize(kept);
+	quad.itemR.resize(kept);
+
+	std::fill(quad.kindCounts, quad.kindCounts + QUAD_KINDS, 0);
+	for (auto item : quad.items) quad.kindCounts[item->kind]++;
+	if (quad.hasSplit()) {
+		for (unsigned int b = 0; b < 4; b++) {
+			auto branch = quad.branches + b;
+			count += takeSubtree(branch, take);
+			for (unsigned int k = 0; k < QUAD_KINDS; k++)
+				quad.kindCounts[k] += nodes[branch].kindCounts[k];
+		}
+		pruneBranches(node);
+	}
+	quad.kinds = 0;
+	for (unsigned int k = 0; k < QUAD_KINDS; k++)
+		if (quad.kindCounts[k]) quad.kinds |= 1 << k;
+	return count;
+}
+
+template<typename F>
+unsigned int QuadTree::consumeDFS(unsigned int node, const CircleBorder& circle, unsigned char kinds, F& take) {
+	auto& quad = nodes[node];
+	float limit = circle.getRadius() * circle.getRadius();
+	// Items below the root fit inside their node's loose bounds, so a node whose farthest corner
+	// is within the circle only holds items lying wholly inside it. A tight tree only sorts items
+	// by side, those on the world edge can hang out past the root, so edge nodes are walked instead.
+	auto& root = nodes[0].range;
+	bool edge = looseness <= 1.0f &&
+		(std::abs(quad.range.getX() - root.getX()) + quad.range.w >= root.w - quad.range.w ||
+		 std::abs(quad.range.getY() - root.getY()) + quad.range.h >= root.h - quad.range.h);
+	if (node && !edge && !(quad.kinds & ~kinds) && rectFarDistSq(circle.center, getLooseRange(node)) <= limit) {
+		unsigned int before[QUAD_KINDS];
+		std::copy(quad.kindCounts, quad.kindCounts + QUAD_KINDS, before);
+		auto count = takeSubtree(node, take);
+		for (unsigned int k = 0; k < QUAD_KINDS; k++)
+			if (before[k] != quad.kindCounts[k])
+				countKind(quad.parent, k, (int) quad.kindCounts[k] - (int) before[k]);
+		return count;
+	}
+	visits++;
+	if (!quad.hasSplit()) return 0;
+	unsigned int count = 0;
+	for (unsigned int b = 0; b < 4; b++) {
+		auto branch = quad.branches + b;
+		if ((nodes[branch].kinds & kinds) && rectDistSq(circle.center, getLooseRange(branch)) < limit)
+			count += consumeDFS(branch, circle, kinds, take);
+	}
+	pruneBranches(node);
+	return count;
+}
+
+template<typename F>
+unsigned int QuadTree::consume(const CircleBorder& circle, unsigned char kinds, F&& take) {
+	if (!(nodes[0].kinds & kinds)) return 0;
+	auto count = consumeDFS(0, circle, kinds, take);
+	countQueries(1);
+	return count;
+}
+
 static std::list<QuadTree*> cleanupQueue;
 static inline void FREE_QUADTREES() {
 	while (cleanupQueue.size()) {
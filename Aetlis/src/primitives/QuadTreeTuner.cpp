@@ -0,0 +1,62 @@
+#include "QuadTreeTuner.h"
+
+// A trial has to beat the best setting by this much to be kept, ticks are noisy
+static const float TUNER_MARGIN = 0.97f;
+
+bool QuadTreeTuner::sample(float cost, unsigned int& treeItems, unsigned int& treeLevel) {
+	if (resting) {
+		resting--;
+		return false;
+	}
+	total += cost;
+	if (++samples < window) return false;
+
+	float average = total / samples;
+	total = 0;
+	samples = 0;
+
+	if (!trial) {
+		bestCost = average;
+		bestItems = treeItems;
+		bestLevel = treeLevel;
+		return propose(treeItems, treeLevel);
+	}
+
+	if (average < bestCost * TUNER_MARGIN) {
+		// Keep going the same way from the new best
+		bestCost = average;
+		bestItems = treeItems;
+		bestLevel = treeLevel;
+		rejected = 0;
+		return propose(treeItems, treeLevel);
+	}
+
+	treeItems = bestItems;
+	treeLevel = bestLevel;
+	trial = false;
+	step = (step + 1) % 4;
+	if (++rejected >= 4) {
+		rejected = 0;
+		resting = window * 8;
+	}
+	return true;
+}
+
+bool QuadTreeTuner::propose(unsigned int& treeItems, unsigned int& treeLevel) {
+	for (unsigned int tries = 0; tries < 4; tries++, step = (step + 1) % 4) {
+		unsigned int items = treeItems, level = treeLevel;
+		switch (step) {
+			case 0: items = treeItems * 2; break;
+			case 1: items = treeItems / 2; break;
+			case 2: level = treeLevel + 1; break;
+			case 3: level = treeLevel - 1; break;
+		}
+		if (items < minItem || items > maxItem || level < minLevel || level > maxLevel) continue;
+		treeItems = items;
+		treeLevel = level;
+		trial = true;
+		return true;
+	}
+	trial = false;
+	return false;
+}
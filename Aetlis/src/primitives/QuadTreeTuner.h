@@ -0,0 +1,31 @@
+#pragma once
+
+// Hill climbs worldFinderMaxItems / worldFinderMaxLevel on measured tick cost.
+// Every setting is timed over a window of ticks; a trial step is kept if it beats
+// the current best by a margin, otherwise it is undone and the next step is tried.
+// After a full round of rejected steps the tuner rests, then measures again since
+// the cell population keeps changing.
+class QuadTreeTuner {
+public:
+	unsigned int window;
+	unsigned int minItem = 4;
+	unsigned int maxItem = 256;
+	unsigned int minLevel = 4;
+	unsigned int maxLevel = 24;
+
+	QuadTreeTuner(unsigned int window = 50) : window(window) {};
+	// Feeds one tick's cost, returns true when the tree should be rebuilt with new limits
+	bool sample(float cost, unsigned int& treeItems, unsigned int& treeLevel);
+private:
+	float total = 0;
+	unsigned int samples = 0;
+	unsigned int resting = 0;
+	float bestCost = 0;
+	unsigned int bestItems = 0;
+	unsigned int bestLevel = 0;
+	unsigned int step = 0;     // next step to try: items x2, items /2, level +1, level -1
+	unsigned int rejected = 0; // steps rejected in a row
+	bool trial = false;
+
+	bool propose(unsigned int& treeItems, unsigned int& treeLevel);
+};
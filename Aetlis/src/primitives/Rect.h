@@ -26,8 +26,8 @@ protected:
 public:
 	Point() : x(0), y(0) {};
 	Point(float x, float y) : x(x), y(y) {};
-	float getX() { return x; };
-	float getY() { return y; };
+	float getX() const { return x; };
+	float getY() const { return y; };
 	void setX(float x) { this->x = x; };
 	void setY(float y) { this->y = y; };
 };
@@ -40,32 +40,33 @@ public:
 	Rect() : Point(), w(0), h(0) {};
 	Rect(float x, float y, float w, float h) : Point(x, y), w(w), h(h) {};
 	
-	bool intersects(const Rect& other) {
+	bool intersects(const Rect& other) const {
 		return x - w <= other.x + other.w && \
 		  	x + w >= other.x - other.w && \
 			y - h <= other.y + other.h && \
 			y + h >= other.y - other.h;
 	}
 
-	bool fullyIntersects(const Rect& other) {
-		return x - w >= other.x + other.w && \
-			x + w <= other.x - other.w && \
-			y - h >= other.y + other.h && \
-			y + h <= other.y - other.h;
+	// True when other lies entirely inside this rect
+	bool fullyIntersects(const Rect& other) const {
+		return x - w <= other.x - other.w && \
+			x + w >= other.x + other.w && \
+			y - h <= other.y - other.h && \
+			y + h >= other.y + other.h;
 	}
 
-	Quadrant getQuadIntersect(const Rect& other) {
-		return ((y - h < other.y || y + h < other.y) && QUAD_T) |
-			   ((y - h > other.y || y + h > other.y) && QUAD_B) |
-			   ((x - w < other.x || x + w < other.x) && QUAD_L) |
-			   ((x - w > other.x || x + w > other.x) && QUAD_R);
+	Quadrant getQuadIntersect(const Rect& other) const {
+		return ((y - h < other.y || y + h < other.y) ? QUAD_T : 0) |
+			   ((y - h > other.y || y + h > other.y) ? QUAD_B : 0) |
+			   ((x - w < other.x || x + w < other.x) ? QUAD_L : 0) |
+			   ((x - w > other.x || x + w > other.x) ? QUAD_R : 0);
 	}
 
-	Quadrant getQuadFullIntersect(const Rect& other) {
-		return ((y - h < other.y && y + h < other.y) && QUAD_T) |
-			   ((y - h > other.y && y + h > other.y) && QUAD_B) |
-			   ((x - w < other.x && x + w < other.x) && QUAD_L) |
-			   ((x - w > other.x && x + w > other.x) && QUAD_R);
+	Quadrant getQuadFullIntersect(const Rect& other) const {
+		return ((y - h < other.y && y + h < other.y) ? QUAD_T : 0) |
+			   ((y - h > other.y && y + h > other.y) ? QUAD_B : 0) |
+			   ((x - w < other.x && x + w < other.x) ? QUAD_L : 0) |
+			   ((x - w > other.x && x + w > other.x) ? QUAD_R : 0);
 	}
 
 	void print(std::ostream& stream) {
@@ -92,9 +93,9 @@ struct CircleBorder {
 	CircleBorder(Point c, float r) : center(c), radius(r) {};
 	CircleBorder(float x, float y, float r) : center(x, y), radius(r) {};
 
-	float getX() { return center.getX(); };
-	float getY() { return center.getY(); };
-	float getRadius() { return radius; };
+	float getX() const { return center.getX(); };
+	float getY() const { return center.getY(); };
+	float getRadius() const { return radius; };
 };
 
 /*
@@ -0,0 +1,60 @@
+#include "SweepAndPrune.h"
+
+static inline float leftEdge(QuadItem* item) {
+	return item->range.getX() - item->range.w;
+}
+
+SweepAndPrune::SweepAndPrune() : Finder(FinderType::SWEEP) {}
+
+void SweepAndPrune::insert(QuadItem* item) {
+	item->node = 0;
+	item->slot = items.size();
+	items.push_back(item);
+	inserted++;
+	dirty = true;
+}
+
+void SweepAndPrune::update(QuadItem* item) {
+	if (item->node == QUAD_NONE) return;
+	dirty = true;
+}
+
+void SweepAndPrune::remove(QuadItem* item) {
+	if (item->node == QUAD_NONE) return;
+	items[item->slot] = nullptr;
+	item->node = QUAD_NONE;
+	dirty = true;
+}
+
+void SweepAndPrune::prepare() {
+	if (!dirty) return;
+	std::lock_guard<std::mutex> guard(sortLock);
+	if (!dirty) return;
+	sort();
+	dirty = false;
+}
+
+void SweepAndPrune::sort() {
+	items.erase(std::remove(items.begin(), items.end(), nullptr), items.end());
+
+	// Bulk loads are nowhere near sorted, insertion sort only pays off for small changes
+	if (inserted > 64 && inserted > items.size() / 16)
+		std::sort(items.begin(), items.end(), [](QuadItem* a, QuadItem* b) { return leftEdge(a) < leftEdge(b); });
+	inserted = 0;
+	for (size_t i = 1; i < items.size(); i++) {
+		auto item = items[i];
+		float left = leftEdge(item);
+		size_t j = i;
+		for (; j > 0 && leftEdge(items[j - 1]) > left; j--)
+			items[j] = items[j - 1];
+		items[j] = item;
+	}
+
+	lefts.resize(items.size());
+	widest = 0;
+	for (size_t i = 0; i < items.size(); i++) {
+		items[i]->slot = i;
+		lefts[i] = leftEdge(items[i]);
+		widest = std::max(widest, 2 * items[i]->range.w);
+	}
+}
@@ -0,0 +1,151 @@
+#pragma once
+
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <algorithm>
+#include "Rect.h"
+#include "Finder.h"
+
+// Sort and sweep on the x axis. Items are kept ordered by their left edge; a query
+// binary searches the window [left - widest item, right] and tests what is inside.
+// Mutations only mark the order stale, it is restored by the first query that follows
+// (insertion sort, since the order is nearly intact between ticks).
+class SweepAndPrune : public Finder {
+public:
+	SweepAndPrune();
+	void insert(QuadItem* item) override;
+	void update(QuadItem* item) override;
+	void remove(QuadItem* item) override;
+
+	template<typename F>
+	unsigned int search(const Rect& rect, F&& callback);
+	template<typename F>
+	bool containAny(const Rect& rect, F&& selector);
+	template<typename F>
+	unsigned int search(const Rect& rect, unsigned char kinds, F&& callback);
+	template<typename F>
+	bool containAny(const Rect& rect, unsigned char kinds, F&& selector);
+	template<typename F>
+	unsigned int searchBatch(const Rect* ranges, unsigned int count, F&& callback);
+	template<typename F>
+	unsigned int searchBatch(const CircleBorder* circles, unsigned int count, F&& callback);
+	template<typename F>
+	unsigned int nearest(const Point& p, float radius, unsigned int k, unsigned char kinds, F&& callback);
+	template<typename F>
+	unsigned int largest(const Point& p, float radius, unsigned int k, unsigned char kinds, F&& callback);
+private:
+	std::vector<QuadItem*> items; // removed items leave a nullptr until the next sort
+	std::vector<float> lefts;     // left edge of items[i] as of the last sort
+	float widest = 0;
+	unsigned int inserted = 0;    // items appended since the last sort
+	std::atomic<bool> dirty = false;
+	std::mutex sortLock;
+
+	// Restores the order, safe to call from concurrent queries
+	void prepare();
+	void sort();
+	template<typename F>
+	bool visit(const Rect& rect, F&& visitor);
+};
+
+template<typename F>
+bool SweepAndPrune::visit(const Rect& rect, F&& visitor) {
+	prepare();
+	auto begin = std::lower_bound(lefts.cbegin(), lefts.cend(), rect.getX() - rect.w - widest);
+	auto end = std::upper_bound(begin, lefts.cend(), rect.getX() + rect.w);
+	for (auto i = begin - lefts.cbegin(); i < end - lefts.cbegin(); i++) {
+		auto item = items[i];
+		if (rect.intersects(item->range) && visitor(item)) return true;
+	}
+	return false;
+}
+
+template<typename F>
+unsigned int SweepAndPrune::search(const Rect& rect, F&& callback) {
+	return search(rect, QUAD_ANY, callback);
+}
+
+template<typename F>
+bool SweepAndPrune::containAny(const Rect& rect, F&& selector) {
+	return visit(rect, selector);
+}
+
+template<typename F>
+unsigned int SweepAndPrune::search(const Rect& rect, unsigned char kinds, F&& callback) {
+	unsigned int count = 0;
+	if (!maxSearch) {
+		visit(rect, [kinds, &count, &callback](QuadItem* item) {
+			if (!(kinds & (1 << item->kind))) return false;
+			callback(item);
+			count++;
+			return false;
+		});
+		return count;
+	}
+
+	// Capped, so keep the items nearest to the middle of rect rather than the first ones reached
+	static thread_local std::vector<RankedItem> ranked;
+	auto base = ranked.size();
+	Point center(rect.getX(), rect.getY());
+	visit(rect, [kinds, &center](QuadItem* item) {
+		if (kinds & (1 << item->kind)) ranked.push_back(std::make_pair(centerDistSq(center, item), item));
+		return false;
+	});
+	return emitRanked(ranked, base, maxSearch, callback);
+}
+
+template<typename F>
+bool SweepAndPrune::containAny(const Rect& rect, unsigned char kinds, F&& selector) {
+	return visit(rect, [kinds, &selector](QuadItem* item) { return (kinds & (1 << item->kind)) && selector(item); });
+}
+
+template<typename F>
+unsigned int SweepAndPrune::nearest(const Point& p, float radius, unsigned int k, unsigned char kinds, F&& callback) {
+	static thread_local std::vector<RankedItem> ranked;
+	auto base = ranked.size();
+	float limit = radius * radius;
+	visit(Rect(p.getX(), p.getY(), radius, radius), [&p, kinds, limit](QuadItem* item) {
+		float dSq = centerDistSq(p, item);
+		if ((kinds & (1 << item->kind)) && dSq <= limit) ranked.push_back(std::make_pair(dSq, item));
+		return false;
+	});
+	return emitRanked(ranked, base, k, callback);
+}
+
+template<typename F>
+unsigned int SweepAndPrune::largest(const Point& p, float radius, unsigned int k, unsigned char kinds, F&& callback) {
+	static thread_local std::vector<RankedItem> ranked;
+	auto base = ranked.size();
+	float limit = radius * radius;
+	visit(Rect(p.getX(), p.getY(), radius, radius), [&p, kinds, limit](QuadItem* item) {
+		if ((kinds & (1 << item->kind)) && centerDistSq(p, item) <= limit)
+			ranked.push_back(std::make_pair(-item->range.w, item));
+		return false;
+	});
+	return emitRanked(ranked, base, k, callback);
+}
+
+template<typename F>
+unsigned int SweepAndPrune::searchBatch(const Rect* ranges, unsigned int count, F&& callback) {
+	unsigned int visited = 0;
+	for (unsigned int q = 0; q < count; q++)
+		visited += search(ranges[q], [q, &callback](QuadItem* item) { return callback(q, item); });
+	return visited;
+}
+
+// Searches the bounding square of each circle and drops the corners
+template<typename F>
+unsigned int SweepAndPrune::searchBatch(const CircleBorder* circles, unsigned int count, F&& callback) {
+	unsigned int visited = 0;
+	for (unsigned int q = 0; q < count; q++) {
+		auto& circle = circles[q];
+		Rect bounds(circle.getX(), circle.getY(), circle.getRadius(), circle.getRadius());
+		search(bounds, [q, &circle, &visited, &callback](QuadItem* item) {
+			if (!circleOverlaps(circle, item)) return false;
+			visited++;
+			return callback(q, item);
+		});
+	}
+	return visited;
+}
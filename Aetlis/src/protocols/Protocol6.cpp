@@ -100,7 +100,7 @@ void Protocol6::onVisibleCellUpdate(vector<Cell*>& add, vector<Cell*>& upd, vect
 
 	writer.writeUInt16(eat.size());
 	for (auto cell : eat) {
-		writer.writeUInt32(cell->eatenBy->id);
+		writer.writeUInt32(cell->eatenById);
 		writer.writeUInt32(cell->id);
 	}
 
@@ -131,16 +131,16 @@ void Protocol6::onVisibleCellUpdate(vector<Cell*>& add, vector<Cell*>& upd, vect
 		writer.writeUInt16(cell->getSize());
 		unsigned char flags = 0;
 		if (cell->isSpiked()) flags |= 0x01;
-		if (cell->colorChanged) flags |= 0x02;
-		if (cell->skinChanged) flags |= 0x04;
-		if (cell->nameChanged) flags |= 0x08;
+		if (cell->cellFlags & COLOR_CHANGED_BIT) flags |= 0x02;
+		if (cell->cellFlags & SKIN_CHANGED_BIT) flags |= 0x04;
+		if (cell->cellFlags & NAME_CHANGED_BIT) flags |= 0x08;
 		if (cell->isAgitated()) flags |= 0x10;
 		if (cell->getType() == CellType::MOTHER_CELL) flags |= 0x20;
 		writer.writeUInt8(flags);
 
-		if (cell->colorChanged) writer.writeColor(cell->getColor());
-		if (cell->skinChanged)  writer.writeStringUTF8(cell->getSkin().data());
-		if (cell->nameChanged)  writer.writeStringUTF8(cell->getName().data());
+		if (cell->cellFlags & COLOR_CHANGED_BIT) writer.writeColor(cell->getColor());
+		if (cell->cellFlags & SKIN_CHANGED_BIT)  writer.writeStringUTF8(cell->getSkin().data());
+		if (cell->cellFlags & NAME_CHANGED_BIT)  writer.writeStringUTF8(cell->getName().data());
 	}
 	writer.writeUInt32(0);
 
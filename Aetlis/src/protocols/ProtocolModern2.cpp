@@ -201,29 +201,29 @@ void ProtocolModern::onVisibleCellUpdate(vector<Cell*>& add, vector<Cell*>& upd,
 	if (upd.size()) {
 		for (auto cell : upd) {
 			flags = 0;
-			if (cell->posChanged)
+			if (cell->cellFlags & POS_CHANGED_BIT)
 				flags |= 1;
-			if (cell->sizeChanged)
+			if (cell->cellFlags & SIZE_CHANGED_BIT)
 				flags |= 2;
-			if (cell->colorChanged)
+			if (cell->cellFlags & COLOR_CHANGED_BIT)
 				flags |= 4;
-			if (cell->nameChanged)
+			if (cell->cellFlags & NAME_CHANGED_BIT)
 				flags |= 8;
-			if (cell->skinChanged)
+			if (cell->cellFlags & SKIN_CHANGED_BIT)
 				flags |= 16;
 			writer.writeUInt32(cell->id);
 			writer.writeUInt8(flags);
-			if (cell->posChanged) {
+			if (cell->cellFlags & POS_CHANGED_BIT) {
 				writer.writeFloat32(cell->getX());
 				writer.writeFloat32(cell->getY());
 			}
-			if (cell->sizeChanged)
+			if (cell->cellFlags & SIZE_CHANGED_BIT)
 				writer.writeUInt16(cell->getSize());
-			if (cell->colorChanged)
+			if (cell->cellFlags & COLOR_CHANGED_BIT)
 				writer.writeColor(cell->getColor());
-			if (cell->nameChanged)
+			if (cell->cellFlags & NAME_CHANGED_BIT)
 				writer.writeStringUTF8(cell->getName().data());
-			if (cell->skinChanged)
+			if (cell->cellFlags & SKIN_CHANGED_BIT)
 				writer.writeStringUTF8(cell->getSkin().data());
 		}
 		writer.writeUInt32(0);
@@ -231,7 +231,7 @@ void ProtocolModern::onVisibleCellUpdate(vector<Cell*>& add, vector<Cell*>& upd,
 	if (eat.size()) {
 		for (auto cell : eat) {
 			writer.writeUInt32(cell->id);
-			writer.writeUInt32(cell->eatenBy->id);
+			writer.writeUInt32(cell->eatenById);
 		}
 		writer.writeUInt32(0);
 	}
@@ -339,7 +339,7 @@ void ProtocolVanis::onVisibleCellUpdate(vector<Cell*>& add, vector<Cell*>& upd,
 	writer.writeUInt32(0);
 	for (auto cell : eat) {
 		writer.writeUInt32(cell->id);
-		writer.writeUInt32(cell->eatenBy->id);
+		writer.writeUInt32(cell->eatenById);
 	}
 	writer.writeUInt32(0);
 	printf("[SERVER LOG] Sending OpCode: 10 (Visible Cell Update)\n");
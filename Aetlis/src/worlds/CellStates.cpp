@@ -0,0 +1,50 @@
+#include "CellStates.h"
+#include "Player.h"
+
+void CellStates::push(Cell* cell) {
+	x.push_back(0);
+	y.push_back(0);
+	size.push_back(0);
+	boost.push_back(Boost());
+	type.push_back(cell->getType());
+	flags.push_back(STATE_EXISTS);
+	ownerId.push_back(0);
+	store(cell);
+}
+
+void CellStates::store(Cell* cell) {
+	auto i = cell->index;
+	x[i] = cell->getX();
+	y[i] = cell->getY();
+	size[i] = cell->getSize();
+	boost[i] = cell->boost;
+	ownerId[i] = cell->owner ? cell->owner->id : 0;
+}
+
+void CellStates::moveLast(unsigned int to) {
+	auto last = count() - 1;
+	x[to] = x[last];
+	y[to] = y[last];
+	size[to] = size[last];
+	boost[to] = boost[last];
+	type[to] = type[last];
+	flags[to] = flags[last];
+	ownerId[to] = ownerId[last];
+	x.pop_back();
+	y.pop_back();
+	size.pop_back();
+	boost.pop_back();
+	type.pop_back();
+	flags.pop_back();
+	ownerId.pop_back();
+}
+
+void CellStates::clear() {
+	x.clear();
+	y.clear();
+	size.clear();
+	boost.clear();
+	type.clear();
+	flags.clear();
+	ownerId.clear();
+}
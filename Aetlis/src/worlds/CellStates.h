@@ -0,0 +1,29 @@
+#pragma once
+
+#include <vector>
+#include "../cells/Cell.h"
+
+// Slot flags
+const unsigned char STATE_EXISTS = 0x01; // cleared by World::removeCell, the slot goes at the next compactCells
+const unsigned char STATE_DIRTY  = 0x02; // range changed since the finder last saw it, see World::flushFinderUpdates
+
+// Hot state of World::cells as parallel arrays, slot i belongs to cells[i]. Scans over the
+// whole world read these instead of pulling every cell object through the cache. Position,
+// size, boost and owner are copies taken by World::addCell and World::updateCell, the same
+// points the finder learns of a change, type never changes and the flags only live here.
+struct CellStates {
+	std::vector<float> x;
+	std::vector<float> y;
+	std::vector<float> size;
+	std::vector<Boost> boost;
+	std::vector<CellType> type;
+	std::vector<unsigned char> flags;
+	std::vector<unsigned int> ownerId; // 0 for ownerless cells
+
+	unsigned int count() const { return (unsigned int) type.size(); };
+	void push(Cell* cell);
+	void store(Cell* cell);
+	// Moves the last slot into slot to and drops the last
+	void moveLast(unsigned int to);
+	void clear();
+};
@@ -16,16 +16,43 @@
 #include <chrono>
 #include <cmath>
 #include <unordered_map>
+#include <functional>
 
 using std::to_string;
 using std::thread;
 
+// Waves with fewer rigid pairs than this are resolved on the tick thread
+static const unsigned int RIGID_WAVE_SPLIT = 256;
+
+// Fewer independent eat pairs than this are eaten on the tick thread
+static const unsigned int EAT_SPLIT = 256;
+
+// Boost and player cell updates over fewer cells than this run on the tick thread
+static const unsigned int INTEGRATE_SPLIT = 512;
+
+// Kinds ejected cells in flight query for, player cells find them from their own side
+static const unsigned char PARTICLE_KINDS = interactionKinds(EJECTED_CELL);
+
+// Pairs of one player's cells are left to solvePlayerGroups
+static inline bool ownPair(Cell* a, Cell* b) {
+	return a->owner && a->owner == b->owner && a->getType() == CellType::PLAYER && b->getType() == CellType::PLAYER;
+}
+
+// Removed cells stay constructed this many ticks after their handles stop resolving. Visibility
+// maps of idle routers and neighbour lists still hold plain pointers to them until then.
+static const unsigned long CELL_RELEASE_DELAY = 100;
+
+// Neighbour lists are dropped after this many ticks at the latest, well before removed
+// cells they may still point to are released
+static const unsigned long NEIGHBOUR_MAX_AGE = 50;
+
 World::World(ServerHandle* handle, unsigned int id) : handle(handle), id(id) {
 	worldChat = new ChatChannel(&handle->listener);
 	physicsPool = new ThreadPool(handle->getSettingInt("physicsThreads"));
 
 	Logger::info(string("Using ") + std::to_string(handle->getSettingInt("physicsThreads")) + " threads to accelerate physics");
 	Logger::info(string("Using ") + std::to_string(handle->getSettingInt("socketsThreads")) + " threads to accelerate sockets");
+	Logger::info(string("Using ") + kernelLevelName(detectKernelLevel()) + " kernels for player cells");
 
 	float x = handle->getSettingInt("worldMapX");
 	float y = handle->getSettingInt("worldMapY");
@@ -68,10 +95,9 @@ World::~World() {
 		player->world = nullptr;
 	}
 	players.clear();
-	for (auto c : cells) delete c;
+	compactCells();
 	cells.clear();
-	for (auto c : gcTruck) delete c;
-	gcTruck.clear();
+	pools.clear();
 	delete worldChat;
 	delete finder;
 	delete physicsPool;
@@ -83,8 +109,36 @@ void World::setBorder(Rect& rect) {
 	int maxLevel = handle->getSettingInt("worldFinderMaxLevel");
 	int maxItems = handle->getSettingInt("worldFinderMaxItems");
 	int maxSearch = handle->getSettingInt("worldFinderMaxSearch");
-	finder = new QuadTree(border, maxLevel, maxItems);
+	float looseness = handle->getSettingFloat("worldFinderLooseness");
+	string type = handle->getSettingString("worldFinderType");
+	if (type == "grid") {
+		finder = new HashGrid(border, handle->getSettingFloat("worldFinderCellSize"));
+	} else if (type == "sweep") {
+		finder = new SweepAndPrune();
+	} else {
+		if (type != "quadtree") Logger::warn("Unknown worldFinderType \"" + type + "\", using quadtree");
+		auto tree = new QuadTree(border, maxLevel, maxItems);
+		tree->looseness = std::max(looseness, 1.0f);
+		finder = tree;
+	}
 	finder->maxSearch = maxSearch;
+	finderRebuild = handle->getSettingBool("worldFinderRebuild");
+	if (finderRebuild && finder->type != FinderType::QUADTREE) {
+		Logger::warn("worldFinderRebuild only applies to the quadtree finder");
+		finderRebuild = false;
+	}
+	deferFinderUpdates = false;
+	finderAutoTune = handle->getSettingBool("worldFinderAutoTune");
+	if (finderAutoTune && finder->type != FinderType::QUADTREE) {
+		Logger::warn("worldFinderAutoTune only applies to the quadtree finder");
+		finderAutoTune = false;
+	}
+	verletSkin = std::max(handle->getSettingFloat("worldVerletSkin"), 0.0f);
+	if (verletSkin > 0 && maxSearch) {
+		Logger::warn("worldVerletSkin does not work with worldFinderMaxSearch, neighbour lists are off");
+		verletSkin = 0;
+	}
+	for (auto c : cells) c->listTick = 0;
 	for (auto cell : cells) {
 		if (cell->getType() == PLAYER) continue;
 		finder->insert(cell);
@@ -96,7 +150,10 @@ void World::setBorder(Rect& rect) {
 void World::addCell(Cell* cell) {
 	cell->exist = true;
 	cell->range = { cell->getX(), cell->getY(), cell->getSize(), cell->getSize() };
+	cell->kind = cell->getType();
+	cell->index = cells.size();
 	cells.push_back(cell);
+	cellStates.push(cell);
 	finder->insert(cell);
 	cell->onSpawned();
 	handle->gamemode->onNewCell(cell);
@@ -106,10 +163,12 @@ void World::restart() {
 	if (!shouldRestart) return;
 
 	Logger::info(string("World (id: ") + to_string(id) + ") restarting!");
-	for (auto c : cells) delete c;
+	compactCells();
 	cells.clear();
-	for (auto c : gcTruck) delete c;
-	gcTruck.clear();
+	cellStates.clear();
+	pools.clear();
+	pelletGrowth.clear();
+	particles.clear();
 	for (auto p : players) {
 		p->lastVisibleCellData.clear();
 		p->lastVisibleCells.clear();
@@ -138,28 +197,146 @@ void World::updateCell(Cell* cell) {
 		cell->getSize(),
 		cell->getSize()
 	};
-	finder->update(cell);
+	cellStates.store(cell);
+	cellStates.flags[cell->index] |= STATE_DIRTY;
+}
+
+// Index updates are batched: updateCell only marks the cell and each phase ends with one
+// flush. Cells that stay in their node are refit in place on the physics pool, the tree is
+// only restructured for the ones that cross a node border.
+void World::flushFinderUpdates() {
+	dirtyCells.clear();
+	auto flags = cellStates.flags.data();
+	for (unsigned int i = 0; i < cells.size(); i++) {
+		if (!(flags[i] & STATE_DIRTY)) continue;
+		flags[i] &= ~STATE_DIRTY;
+		if (flags[i] & STATE_EXISTS && !deferFinderUpdates) dirtyCells.push_back(cells[i]);
+	}
+	if (dirtyCells.empty()) return;
+	if (finder->type != FinderType::QUADTREE) {
+		for (auto c : dirtyCells) finder->update(c);
+		return;
+	}
+	auto tree = static_cast<QuadTree*>(finder);
+	vector<unsigned char> moving(dirtyCells.size(), 0);
+	forEachSlice(dirtyCells.size(), [this, tree, &moving](unsigned int from, unsigned int to) {
+		for (unsigned int i = from; i < to; i++)
+			moving[i] = !tree->refit(dirtyCells[i]);
+	});
+	for (unsigned int i = 0; i < dirtyCells.size(); i++)
+		if (moving[i]) tree->update(dirtyCells[i]);
 }
 
 void World::removeCell(Cell* cell) {
 	if (!cell->exist) return;
 	cell->exist = false;
+	cellStates.flags[cell->index] &= ~STATE_EXISTS;
 	cell->deadTick = handle->tick;
-	gcTruck.push_back(cell);
+	pools.retire(cell, handle->tick);
+	removedCells.push_back(cell);
 	handle->gamemode->onCellRemove(cell);
 	cell->onRemoved();
 	finder->remove(cell);
 }
 
-void World::clearTruck() {
-	auto iter = gcTruck.begin();
-	while (iter != gcTruck.end()) {
-		auto cell = *iter;
-		if (handle->tick - cell->deadTick > 100) {
-			delete cell;
-			iter = gcTruck.erase(iter);
-		} else break;
+// Drops removed cells from cells, moving the last cell into each freed slot
+void World::compactCells() {
+	for (auto cell : removedCells) {
+		auto last = cells.back();
+		cells[cell->index] = last;
+		cellStates.moveLast(cell->index);
+		last->index = cell->index;
+		cells.pop_back();
+	}
+	removedCells.clear();
+}
+
+// Sorts the living cells by Morton code on the physics pool and bulk loads a fresh tree
+// from them, mortonCells is left in that order for the collision pass to walk
+void World::rebuildFinder() {
+	Stopwatch bench;
+	bench.begin();
+
+	auto tree = static_cast<QuadTree*>(finder);
+	mortonCells.clear();
+	for (unsigned int i = 0; i < cells.size(); i++)
+		if (cellStates.flags[i] & STATE_EXISTS) mortonCells.push_back(std::make_pair(0, cells[i]));
+
+	unsigned int threads = std::max(1, handle->runtime.physicsThreads);
+	vector<MortonItem*> chunks(threads + 1);
+	for (unsigned int i = 0; i <= threads; i++)
+		chunks[i] = mortonCells.data() + mortonCells.size() * i / threads;
+
+	auto byCode = [](const MortonItem& a, const MortonItem& b) { return a.first < b.first; };
+	for (unsigned int offset = 0; offset < threads; offset++) {
+		physicsPool->enqueue([tree, offset, &chunks, &byCode]() {
+			for (auto iter = chunks[offset]; iter != chunks[offset + 1]; iter++)
+				iter->first = tree->mortonCode(iter->second);
+			std::sort(chunks[offset], chunks[offset + 1], byCode);
+		});
+	}
+	physicsPool->waitFinished();
+
+	// Merge sorted chunks pairwise, halving the run count each round
+	for (unsigned int width = 1; width < threads; width *= 2) {
+		for (unsigned int i = 0; i + width < threads; i += 2 * width) {
+			auto first = chunks[i], middle = chunks[i + width], last = chunks[std::min(i + 2 * width, threads)];
+			physicsPool->enqueue([first, middle, last, &byCode]() {
+				std::inplace_merge(first, middle, last, byCode);
+			});
+		}
+		physicsPool->waitFinished();
+	}
+
+	handle->timing.mortonSort = bench.lap();
+	tree->rebuild(mortonCells);
+	deferFinderUpdates = false;
+	handle->timing.finderBuild = bench.lap();
+}
+
+// Publishes this tick's quadtree counters and lets the tuner adjust the limits
+void World::compileFinderStats() {
+	if (finder->type != FinderType::QUADTREE) return;
+	auto tree = static_cast<QuadTree*>(finder);
+	auto& counters = tree->counters;
+	auto& timing = handle->timing;
+	auto shape = tree->getShape();
+	unsigned int queries = counters.queries;
+	unsigned long visited = counters.nodesVisited;
+
+	timing.finderNodes = static_cast<float>(shape.nodes);
+	timing.finderDepth = static_cast<float>(shape.depthItems.size());
+	timing.itemsPerLeaf = shape.itemsPerLeaf();
+	timing.nodesPerQuery = queries ? static_cast<float>(visited) / queries : 0.0f;
+	timing.finderSplits = static_cast<float>(counters.splits);
+	timing.finderMerges = static_cast<float>(counters.merges);
+	timing.finderMaxItems = static_cast<float>(tree->maxItem);
+	timing.finderMaxLevel = static_cast<float>(tree->maxLevel);
+
+	if (handle->bench) {
+		string depths;
+		for (auto count : shape.depthItems) depths += " " + to_string(count);
+		printf("Finder: %u nodes, %u leaves, %.1f items/leaf (max %u), %.1f nodes/query (%u queries), "
+			"%u splits, %u merges, %u moves, items by depth:%s\n",
+			shape.nodes, shape.leaves, shape.itemsPerLeaf(), shape.maxLeafItems, timing.nodesPerQuery, queries,
+			counters.splits, counters.merges, counters.moves, depths.c_str());
 	}
+	counters.reset();
+
+	if (!finderAutoTune) return;
+	// The limits do not change the movement and physics timed in these phases, only the finder share
+	float cost = timing.boostCell + timing.updatePC + timing.sortCell + timing.quadTree;
+	unsigned int maxItem = tree->maxItem, maxLevel = tree->maxLevel;
+	if (!finderTuner.sample(cost, maxItem, maxLevel)) return;
+	Logger::debug(string("Finder limits: ") + to_string(maxItem) + " items, " + to_string(maxLevel) + " levels");
+	tree->maxItem = maxItem;
+	tree->maxLevel = maxLevel;
+	rebuildFinder();
+}
+
+// Gives the memory of cells removed long enough ago back to their pools
+void World::releaseCells() {
+	if (handle->tick > CELL_RELEASE_DELAY) pools.release(handle->tick - CELL_RELEASE_DELAY - 1);
 }
 
 void World::addPlayer(Player* player) {
@@ -206,7 +383,8 @@ void World::killPlayer(Player* player, bool instantKill) {
 			removeCell(c);
 		} else {
 			c->owner = nullptr;
-			c->posChanged = true;
+			cellStates.store(c);
+			c->cellFlags |= POS_CHANGED_BIT;
 			c->id = getNextCellId();
 			if (c->data) c->data->dead = true;
 		}
@@ -230,7 +408,8 @@ Point World::getRandomPos(float cellSize) {
 }
 
 bool World::isSafeSpawnPos(Rect& range) {
-	return !finder->containAny(range, [](auto item) { return ((Cell*) item)->shouldAvoidWhenSpawning(); });
+	// Pellets and ejected mass never block a spawn, skip them before the virtual call
+	return !finder->containAny(range, SPAWN_AVOID_MASK, [](auto item) { return ((Cell*) item)->shouldAvoidWhenSpawning(); });
 }
 
 Point World::getSafeSpawnPos(float& cellSize, bool& failed) {
@@ -319,7 +498,7 @@ void World::spawnPlayer(Player* player, Point& pos, float size) {
 			((Connection*)other->router)->protocol->onPlayerSpawned(player);
 	}
 
-	auto playerCell = new PlayerCell(this, player, pos.getX(), pos.getY(), size);
+	auto playerCell = pools.players.create(this, player, pos.getX(), pos.getY(), size);
 	addCell(playerCell);
 	player->joinTick = handle->tick;
 	player->updateState(PlayerState::ALIVE);
@@ -360,7 +539,11 @@ void World::liveUpdate() {
 	bench.begin();
 
 	handle->gamemode->onWorldTick(this);
-	for (auto c : cells) c->onTick();
+	growPellets();
+	// Indexed, ticking cells may spawn more (mother cells) and those tick too. Pellets only
+	// change when they grow and that sets no change bits, they are left out.
+	for (unsigned int i = 0; i < cells.size(); i++)
+		if (cellStates.type[i] != CellType::PELLET) cells[i]->onTick();
 
 	handle->timing.tickCells = bench.lap();
 
@@ -369,21 +552,21 @@ void World::liveUpdate() {
 	while (diff-- > 0) {
 		float spawnSize = handle->runtime.pelletMinSize;
 		auto pos = getSafeSpawnPos(spawnSize, failed);
-		if (!failed) addCell(new Pellet(this, this, pos.getX(), pos.getY()));
+		if (!failed) addCell(pools.pellets.create(this, this, pos.getX(), pos.getY()));
 	}
 
 	diff = handle->runtime.virusMinCount - virusCount;
 	while (diff-- > 0) {
 		float spawnSize = handle->runtime.virusSize + 200.0f;
 		auto pos = getSafeSpawnPos(spawnSize, failed);
-		if (!failed) addCell(new Virus(this, pos.getX(), pos.getY()));
+		if (!failed) addCell(pools.viruses.create(this, pos.getX(), pos.getY()));
 	}
 
 	diff = handle->runtime.mothercellCount - motherCellCount;
 	while (diff-- > 0) {
 		float spawnSize = handle->runtime.mothercellSize + 200.0f;
 		auto pos = getSafeSpawnPos(spawnSize, failed);
-		if (!failed) addCell(new MotherCell(this, pos.getX(), pos.getY()));
+		if (!failed) addCell(pools.motherCells.create(this, pos.getX(), pos.getY()));
 	}
 
 	handle->timing.spawnCell = bench.lap();
@@ -391,31 +574,19 @@ void World::liveUpdate() {
 	list<pair<Cell*, Cell*>> rigid;
 	list<pair<Cell*, Cell*>> eat;
 
-	atomic<unsigned int> max_query_per_cell = 0;
 	atomic<unsigned int> queries = 0;
-	unsigned int insides = 0;
 
-	for (auto c : cells) {
-		if (c->getType() == CellType::PELLET) continue;
-		boostCell(c);
-		if (c->inside) {
-			c->inside = false;
-			insides++;
-		}
-	}
+	// Index updates are dropped from here on, the tree is rebuilt before collisions
+	deferFinderUpdates = finderRebuild;
+
+	unsigned int insides = boostCells();
+	moveParticles();
 
 	handle->timing.insides = static_cast<float>(insides);
 	handle->timing.boostCell = bench.lap();
 	
-	for (auto c : cells) {
-		if (c->getType() != CellType::PLAYER) continue;
-		auto pc = static_cast<PlayerCell*>(c);
-		movePlayerCell(pc);
-		decayPlayerCell(pc);
-		autosplitPlayerCell(pc);
-		bounceCell(pc);
-		updateCell(pc);
-	}
+	updatePlayerCells();
+	flushFinderUpdates();
 
 	handle->timing.updatePC = bench.lap();
 	
@@ -425,62 +596,197 @@ void World::liveUpdate() {
 	//	return (a->getSize() - a->getAge() * 0.1f) > (b->getSize() - b->getAge() * 0.1f);
 	//});
 
-	handle->timing.sortCell = bench.lap();
+	if (finderRebuild) rebuildFinder();
 
-	for (int offset = 0; offset < handle->runtime.physicsThreads; offset++) {
-		physicsPool->enqueue([this, offset, &rigid, &eat, &mtx, &queries, &max_query_per_cell]() {
+	handle->timing.sortCell = bench.lap();
 
-			list<pair<Cell*, Cell*>> thread_rigid;
-			list<pair<Cell*, Cell*>> thread_eat;
+	if (handle->runtime.worldEatBulkSize > 0 && finder->type == FinderType::QUADTREE) {
+		bulkEatPellets();
+		flushFinderUpdates();
+	}
 
-			auto index = offset;
-			auto start = cells.cbegin();
-			std::advance(start, offset);
+	handle->timing.bulkEat = bench.lap();
+
+	// Collision probes for this tick as circles, answered in chunks with one batched tree walk each.
+	// Ejected cells in flight query apart from them, only for PARTICLE_KINDS.
+	vector<Cell*> probes;
+	vector<CircleBorder> probeCircles;
+	vector<Cell*> particleProbes;
+	auto addProbe = [this, &probes, &probeCircles, &particleProbes](Cell* c) {
+		if (c->getType() == CellType::PELLET || c->inside ||
+	//		c->getType() == CellType::VIRUS  ||
+			(c->getType() == CellType::EJECTED_CELL &&
+			 (c->getAge() <= 1 || !c->isBoosting()))) return;
+		c->probe = true;
+		if (c->getType() == CellType::EJECTED_CELL && verletSkin <= 0) {
+			particleProbes.push_back(c);
+			return;
+		}
+		probes.push_back(c);
+		probeCircles.push_back(CircleBorder(c->getX(), c->getY(), c->getSize()));
+	};
+	// After a rebuild, probing in Morton order keeps neighbouring queries on the same nodes
+	if (finderRebuild) {
+		for (auto [code, item] : mortonCells) addProbe((Cell*) item);
+	} else {
+		for (unsigned int i = 0; i < cells.size(); i++)
+			if (cellStates.type[i] != CellType::PELLET) addProbe(cells[i]);
+	}
 
-			while (index < cells.size()) {
-				auto c = *start;
-				std::advance(start, handle->runtime.physicsThreads);
-				index += handle->runtime.physicsThreads;
+	unsigned int threads = std::max(1, handle->runtime.physicsThreads);
+	if (verletSkin > 0) refreshNeighbours(probes);
+
+	// Workers pull chunks until none are left, so a thread stuck in a crowded area does not hold
+	// the rest up. Chunks stay large enough for neighbouring probes to share the tree walk.
+	unsigned int chunk = std::max(32u, (unsigned int) probes.size() / (threads * 8));
+	unsigned int particleChunk = std::max(32u, (unsigned int) particleProbes.size() / (threads * 8));
+	atomic<unsigned int> nextProbe = 0;
+	atomic<unsigned int> nextParticle = 0;
+	// Two probes find each other, so the pair is only taken by the one with the lower id and judged
+	// from both sides there. A capped search may drop either side, then every probe takes all it finds.
+	bool canonical = !finder->maxSearch;
+	auto interaction = getInteractionParams();
+	for (unsigned int offset = 0; offset < threads; offset++) {
+		physicsPool->enqueue([this, chunk, particleChunk, canonical, &interaction, &nextProbe, &nextParticle, &probes, &probeCircles,
+			&particleProbes, &rigid, &eat, &mtx, &queries]() {
 
-				if (c->getType() == CellType::PELLET || c->inside ||
-			//		c->getType() == CellType::VIRUS  ||
-					(c->getType() == CellType::EJECTED_CELL && 
-					 (c->getAge() <= 1 || !c->isBoosting()))) continue;
+			list<pair<Cell*, Cell*>> thread_rigid;
+			list<pair<Cell*, Cell*>> thread_eat;
+			unsigned int q = 0;
+
+			// Queues what touching cells do to each other, returns whether they collide
+			auto classify = [&interaction, &thread_rigid, &thread_eat](Cell* c, Cell* other, bool mutual) {
+				auto forward = getEatResult(interaction, c, other);
+				auto backward = mutual ? getEatResult(interaction, other, c) : EatResult::NONE;
+				if (forward == EatResult::EAT || backward == EatResult::EATINVD)
+					thread_eat.push_back(std::make_pair(c, other));
+				if (forward == EatResult::EATINVD || backward == EatResult::EAT)
+					thread_eat.push_back(std::make_pair(other, c));
+				if (forward == EatResult::COLLIDE || backward == EatResult::COLLIDE) {
+					thread_rigid.push_back(std::make_pair(c, other));
+					return true;
+				}
+				return false;
+			};
 
-				auto q = finder->search(c->range, [&c, &thread_rigid, &thread_eat](auto o) {
+			// A capped search counts collisions as it goes, so its pairs are judged one at a time
+			auto judge = [&classify](Cell* c, Cell* other, float dSq) {
+				if (c->getSize() > other->getSize()) {
+					if (dSq < c->getSize()) other->inside = true;
+				} else {
+					if (dSq < other->getSize()) c->inside = true;
+				}
+				return classify(c, other, false);
+			};
+
+			// Everything else gathers candidates until the batch is full or the chunk done, tests them
+			// a vector at a time and only classifies the pairs that touch, in the order they were found
+			struct Contact {
+				Cell* cell;
+				Cell* other;
+				bool mutual;
+			};
+			vector<Contact> contacts;
+			contacts.reserve(CONTACT_BATCH_SIZE);
+			ContactBatch batch;
+			auto gather = [&contacts, &batch](Cell* c, Cell* other, bool mutual) {
+				contacts.push_back({ c, other, mutual });
+				batch.add(c->getX(), c->getY(), c->getSize(), other->getX(), other->getY(), other->getSize());
+			};
+			auto narrowPhase = [&contacts, &batch, &classify]() {
+				testContacts(batch, 0, batch.pad());
+				unsigned int touching = 0;
+				for (unsigned int i = 0; i < batch.count; i++) {
+					auto flags = batch.flags[i];
+					if (!(flags & CONTACT_TOUCH)) continue;
+					auto& contact = contacts[i];
+					if (flags & CONTACT_PROBE_INSIDE) contact.cell->inside = true;
+					// Seen from other's side a cell of the same size marks other instead
+					if (flags & CONTACT_OTHER_INSIDE || (contact.mutual && flags & CONTACT_TIE))
+						contact.other->inside = true;
+					classify(contact.cell, contact.other, contact.mutual);
+					touching++;
+				}
+				contacts.clear();
+				batch.clear();
+				return touching;
+			};
+
+			unsigned int begin;
+			while ((begin = nextProbe.fetch_add(chunk)) < probes.size()) {
+				unsigned int end = std::min(begin + chunk, (unsigned int) probes.size());
+				if (verletSkin > 0) {
+					// Of two probes only the later list is sure to hold the other, ties go to the lower id
+					for (unsigned int i = begin; i < end; i++) {
+						auto c = probes[i];
+						for (auto other : c->neighbours) {
+							if (!other->exist || ownPair(c, other)) continue;
+							bool mutual = other->probe;
+							if (mutual && (other->listTick > c->listTick ||
+								(other->listTick == c->listTick && other->id < c->id))) continue;
+							if (batch.full()) q += narrowPhase();
+							gather(c, other, mutual);
+						}
+					}
+					q += narrowPhase();
+					continue;
+				}
+				if (!canonical) {
+					q += finder->searchBatch(probeCircles.data() + begin, end - begin,
+						[&probes, begin, &judge](unsigned int index, QuadItem* o) {
+						auto c = probes[begin + index];
+						auto other = (Cell*) o;
+						if (!other->exist) return false;
+						if (c->id == other->id || ownPair(c, other)) return false;
+
+						auto dx = c->getX() - other->getX();
+						auto dy = c->getY() - other->getY();
+						return judge(c, other, dx * dx + dy * dy);
+					});
+					continue;
+				}
+				q += finder->searchBatch(probeCircles.data() + begin, end - begin,
+					[&probes, begin, &batch, &gather, &narrowPhase](unsigned int index, QuadItem* o) {
+					auto c = probes[begin + index];
 					auto other = (Cell*) o;
 					if (!other->exist) return false;
-					if (c->id == other->id) return false;
-
-					auto dx = c->getX() - other->getX();
-					auto dy = c->getY() - other->getY();
-					auto dSq = dx * dx + dy * dy;
-
-					if (c->getSize() > other->getSize()) {
-						if (dSq < c->getSize()) other->inside = true;
-					} else {
-						if (dSq < other->getSize()) c->inside = true;
-					}
-
-					switch (c->getEatResult(other)) {
-						case EatResult::COLLIDE:
-							thread_rigid.push_back(std::make_pair(c, other));
-							return true;
-						case EatResult::EAT:
-							thread_eat.push_back(std::make_pair(c, other));
-							return false;
-						case EatResult::EATINVD:
-							thread_eat.push_back(std::make_pair(other, c));
-							return false;
-                        case EatResult::NONE:
-							return false;
-						default:
-							return false;
-					}
+					if (c->id == other->id || ownPair(c, other)) return false;
+					// A particle only finds c if it acts on c's kind, otherwise c takes the pair
+					bool mutual = other->probe && (other->getType() != CellType::EJECTED_CELL ||
+						(PARTICLE_KINDS & cellTypeMask(c->getType())));
+					if (mutual && other->id < c->id) return false;
+					if (batch.full()) narrowPhase();
+					gather(c, other, mutual);
+					return false;
 				});
-				queries += q;
-				max_query_per_cell = std::max(max_query_per_cell.load(), q);
+				narrowPhase();
+			}
+
+			// Particles in flight walk the tree one at a time, skipping subtrees of pellets and players
+			while ((begin = nextParticle.fetch_add(particleChunk)) < particleProbes.size()) {
+				unsigned int end = std::min(begin + particleChunk, (unsigned int) particleProbes.size());
+				for (unsigned int i = begin; i < end; i++) {
+					auto c = particleProbes[i];
+					CircleBorder circle(c->getX(), c->getY(), c->getSize());
+					Rect reach(c->getX(), c->getY(), c->getSize(), c->getSize());
+					q += finder->search(reach, PARTICLE_KINDS, [c, canonical, &circle, &batch, &gather, &narrowPhase, &judge](QuadItem* o) {
+						auto other = (Cell*) o;
+						if (!other->exist || c->id == other->id || !circleOverlaps(circle, o)) return false;
+						if (!canonical) {
+							auto dx = c->getX() - other->getX();
+							auto dy = c->getY() - other->getY();
+							return judge(c, other, dx * dx + dy * dy);
+						}
+						bool mutual = other->probe;
+						if (mutual && other->id < c->id) return false;
+						if (batch.full()) narrowPhase();
+						gather(c, other, mutual);
+						return false;
+					});
+				}
+				if (canonical) narrowPhase();
 			}
+			queries += q;
 
 			mtx.lock();
 			rigid.splice(rigid.begin(), thread_rigid);
@@ -493,25 +799,24 @@ void World::liveUpdate() {
 
 	handle->timing.quadTree = bench.lap();
 
-	for (auto [r1, r2] : rigid)
-		resolveRigidCheck(r1, r2);
+	// Own cell pairs go by the same probe flags as the probe pass
+	solvePlayerGroups(eat);
+	for (auto c : probes) c->probe = false;
+	for (auto c : particleProbes) c->probe = false;
 
-	handle->timing.rgdCheck = bench.lap();
+	handle->timing.groupSolve = bench.lap();
 
-	eat.sort([](pair<Cell*, Cell*> pairA, pair<Cell*, Cell*> pairB) { 
-		return (pairA.first->getSize() - pairA.first->getAge() * 0.1f) > 
-		       (pairB.first->getSize() - pairB.first->getAge() * 0.1f);
-	});
+	resolveRigidPairs(rigid);
+	flushFinderUpdates();
+
+	handle->timing.rgdCheck = bench.lap();
 
-	for (auto [c1, c2] : eat)
-		resolveEatCheck(c1, c2);
+	resolveEatPairs(eat);
+	flushFinderUpdates();
 
 	handle->timing.eatCheck = bench.lap();
 
-	auto r_iter = cells.begin();
-	while (r_iter != cells.cend())
-		if (!(*r_iter)->exist) r_iter = cells.erase(r_iter);
-		else r_iter++;
+	compactCells();
 
 	largestPlayer = nullptr;
 	for (auto p : players)
@@ -651,10 +956,14 @@ void World::liveUpdate() {
 		original_player_in_loop->updateViewArea();
 	}
 
+	// Splits and ejects above resized cells, the next tick starts with a current index
+	flushFinderUpdates();
+
 	handle->timing.queryOPs = static_cast<float>(queries.load());
 	handle->timing.viewarea = bench.lap();
 	handle->timing.totalCells = static_cast<float>(cells.size());
 
+	compileFinderStats();
 	compileStatistics();
 	handle->gamemode->compileLeaderboard(this);
 
@@ -663,13 +972,31 @@ void World::liveUpdate() {
 			toBeRemoved = true;
 }
 
+InteractionParams World::getInteractionParams() {
+	InteractionParams params;
+	params.tick = handle->tick;
+	params.stepMult = handle->stepMult;
+	params.noCollideDelay = handle->runtime.playerNoCollideDelay;
+	params.eatMult = handle->runtime.worldEatMult;
+	params.spawnProtection = handle->runtime.spawnProtection;
+	params.virusFull = virusCount >= handle->runtime.virusMaxCount;
+	return params;
+}
+
+// One pair on the calling thread, resolveRigidPairs splits the two steps around its waves
 void World::resolveRigidCheck(Cell* a, Cell* b) {
-	if (a->getAge() <= 1 || b->getAge() <= 1) return;
+	if (!pushApart(a, b)) return;
+	if (a->owner && b->owner && a->owner == b->owner) checkLineLock(a->owner, a, b);
+}
+
+// Pushes two overlapping cells apart by their masses, returns whether they overlapped
+bool World::pushApart(Cell* a, Cell* b) {
+	if (a->getAge() <= 1 || b->getAge() <= 1) return false;
 	float dx = b->getX() - a->getX();
 	float dy = b->getY() - a->getY();
 	float d = sqrtf(dx * dx + dy * dy); // Using sqrtf from cmath
 	float m = a->getSize() + b->getSize() - d;
-	if (m <= 0) return;
+	if (m <= 0) return false;
 	if (fabsf(d) < 1e-5f) d = 1.f, dx = 1.f, dy = 0.f; // Avoid division by zero if d is very small
 	else dx /= d, dy /= d;
 	
@@ -718,79 +1045,281 @@ void World::resolveRigidCheck(Cell* a, Cell* b) {
 		final_push_by *= bigCellResistanceFactor;
 	}
 
-	// ---- BEGIN MODIFICATION FOR LINESPLIT-LIKE BEHAVIOR & FEED EXCEPTION ----
-	if (a->owner && b->owner && a->owner == b->owner) { // Player owns both cells
-		Player* commonOwner = a->owner;
-		Router* router = commonOwner->router;
-		
-		bool useProjection = false; // Master flag to decide if projection physics apply this tick
-		unsigned long currentTick = handle->tick;
-
-		bool genericLockOn = commonOwner->isLineLocked.load();
-		bool specialLockOn = commonOwner->specialLineSplitLockActive;
+	a->setX(a->getX() + final_push_ax);
+	a->setY(a->getY() + final_push_ay);
+	b->setX(b->getX() + final_push_bx);
+	b->setY(b->getY() + final_push_by);
+	
+	bounceCell(a);
+	bounceCell(b);
+	updateCell(a);
+	updateCell(b);
+	return true;
+}
 
-		if (specialLockOn && genericLockOn) {
-			// Logger::debug("[ResolveRigidCheck] Player " + std::to_string(commonOwner->id) + ": Special & Generic Lock ON. Will attempt UNTIMED projection.");
-			useProjection = true;
-		} else if (genericLockOn) { // Special lock is OFF, only Generic lock is ON
-			// Logger::debug("[ResolveRigidCheck] Player " + std::to_string(commonOwner->id) + ": Only Generic Lock ON. Checking timed conditions...");
-			if (commonOwner->needsProjectionReactivation) {
-				// Logger::debug("[ResolveRigidCheck] Player " + std::to_string(commonOwner->id) + ": Generic Lock requires reactivation. No projection.");
-				useProjection = false;
-			} else if (commonOwner->projectionActiveUntilTick != 0 && currentTick > commonOwner->projectionActiveUntilTick) {
-				Logger::info("[ResolveRigidCheck] Player " + std::to_string(commonOwner->id) + ": Generic Lock 1-second window EXPIRED (current: " + std::to_string(currentTick) + ", until: " + std::to_string(commonOwner->projectionActiveUntilTick) + "). Reactivation needed. No projection.");
-				commonOwner->needsProjectionReactivation = true; // Mark for reactivation
-				useProjection = false;
-			} else {
-				// Logger::debug("[ResolveRigidCheck] Player " + std::to_string(commonOwner->id) + ": Generic Lock active within 1s window. Will attempt TIMED projection.");
-				useProjection = true;
-			}
+// Linelock projection bookkeeping after two cells of commonOwner collided. It reads and writes
+// plain fields of the owner, so it must never run for one owner on two threads at once:
+// solvePlayerGroups calls it from the worker holding the player, resolveRigidPairs from the
+// tick thread after its waves.
+void World::checkLineLock(Player* commonOwner, Cell* a, Cell* b) {
+	// ---- BEGIN MODIFICATION FOR LINESPLIT-LIKE BEHAVIOR & FEED EXCEPTION ----
+	Router* router = commonOwner->router;
+	
+	bool useProjection = false; // Master flag to decide if projection physics apply this tick
+	unsigned long currentTick = handle->tick;
+
+	bool genericLockOn = commonOwner->isLineLocked.load();
+	bool specialLockOn = commonOwner->specialLineSplitLockActive;
+
+	if (specialLockOn && genericLockOn) {
+		// Logger::debug("[ResolveRigidCheck] Player " + std::to_string(commonOwner->id) + ": Special & Generic Lock ON. Will attempt UNTIMED projection.");
+		useProjection = true;
+	} else if (genericLockOn) { // Special lock is OFF, only Generic lock is ON
+		// Logger::debug("[ResolveRigidCheck] Player " + std::to_string(commonOwner->id) + ": Only Generic Lock ON. Checking timed conditions...");
+		if (commonOwner->needsProjectionReactivation) {
+			// Logger::debug("[ResolveRigidCheck] Player " + std::to_string(commonOwner->id) + ": Generic Lock requires reactivation. No projection.");
+			useProjection = false;
+		} else if (commonOwner->projectionActiveUntilTick != 0 && currentTick > commonOwner->projectionActiveUntilTick) {
+			Logger::info("[ResolveRigidCheck] Player " + std::to_string(commonOwner->id) + ": Generic Lock 1-second window EXPIRED (current: " + std::to_string(currentTick) + ", until: " + std::to_string(commonOwner->projectionActiveUntilTick) + "). Reactivation needed. No projection.");
+			commonOwner->needsProjectionReactivation = true; // Mark for reactivation
+			useProjection = false;
 		} else {
-			// Neither special lock is active, nor is generic lock by itself. No projection.
-			// Logger::debug("[ResolveRigidCheck] Player " + std::to_string(commonOwner->id) + ": No relevant locks active for projection.");
+			// Logger::debug("[ResolveRigidCheck] Player " + std::to_string(commonOwner->id) + ": Generic Lock active within 1s window. Will attempt TIMED projection.");
+			useProjection = true;
+		}
+	} else {
+		// Neither special lock is active, nor is generic lock by itself. No projection.
+		// Logger::debug("[ResolveRigidCheck] Player " + std::to_string(commonOwner->id) + ": No relevant locks active for projection.");
+		useProjection = false;
+	}
+
+	// If any projection type is potentially active, perform common safety checks
+	if (useProjection) {
+		if (!router) {
+			Logger::debug("[ResolveRigidCheck] Router is null for player " + std::to_string(commonOwner->id) + ". Projection aborted.");
 			useProjection = false;
+			// If this was due to a generic timed lock attempt, it now needs reactivation.
+			if (genericLockOn && !specialLockOn) commonOwner->needsProjectionReactivation = true;
 		}
 
-		// If any projection type is potentially active, perform common safety checks
-		if (useProjection) {
-			if (!router) {
-				Logger::debug("[ResolveRigidCheck] Router is null for player " + std::to_string(commonOwner->id) + ". Projection aborted.");
+		if (useProjection) { // Re-check after router check
+			const unsigned long FEED_MAX_AGE_TICKS = (handle->tickDelay > 0) ? (250 / handle->tickDelay) : 5;
+			bool isRecentFeedCollision = false;
+			if (a->getType() == PLAYER && b->getType() == EJECTED_CELL && b->owner == commonOwner && b->getAge() < FEED_MAX_AGE_TICKS) isRecentFeedCollision = true;
+			else if (b->getType() == PLAYER && a->getType() == EJECTED_CELL && a->owner == commonOwner && a->getAge() < FEED_MAX_AGE_TICKS) isRecentFeedCollision = true;
+
+			if (isRecentFeedCollision) {
+				Logger::debug("[ResolveRigidCheck] Player " + std::to_string(commonOwner->id) + " collision with own recent feed. Projection aborted.");
 				useProjection = false;
 				// If this was due to a generic timed lock attempt, it now needs reactivation.
 				if (genericLockOn && !specialLockOn) commonOwner->needsProjectionReactivation = true;
 			}
+		}
+	}
+	
+	// ---- END MODIFICATION ----
+}
 
-			if (useProjection) { // Re-check after router check
-				const unsigned long FEED_MAX_AGE_TICKS = (handle->tickDelay > 0) ? (250 / handle->tickDelay) : 5;
-				bool isRecentFeedCollision = false;
-				if (a->getType() == PLAYER && b->getType() == EJECTED_CELL && b->owner == commonOwner && b->getAge() < FEED_MAX_AGE_TICKS) isRecentFeedCollision = true;
-				else if (b->getType() == PLAYER && a->getType() == EJECTED_CELL && a->owner == commonOwner && a->getAge() < FEED_MAX_AGE_TICKS) isRecentFeedCollision = true;
-
-				if (isRecentFeedCollision) {
-					Logger::debug("[ResolveRigidCheck] Player " + std::to_string(commonOwner->id) + " collision with own recent feed. Projection aborted.");
-					useProjection = false;
-					// If this was due to a generic timed lock attempt, it now needs reactivation.
-					if (genericLockOn && !specialLockOn) commonOwner->needsProjectionReactivation = true;
-				}
+// Collisions and merges among the cells of one player, which the probe pass leaves out. Each
+// player's cells are swept on their own instead of asking the finder, and players own disjoint
+// cells, so the physics pool workers take whole players. As in the probe pass, a pair is only
+// taken when one of its cells probes this tick. Merges join the eat pairs of the tick. Pushes go
+// in sweep order inside the player and all of them before the rigid list, where they used to be
+// mixed in with the other pairs in list order.
+void World::solvePlayerGroups(list<pair<Cell*, Cell*>>& eat) {
+	vector<Player*> groups;
+	for (auto p : players)
+		if (p->ownedCells.size() > 1) groups.push_back(p);
+	if (groups.empty()) return;
+
+	auto interaction = getInteractionParams();
+	std::mutex mtx;
+	atomic<unsigned int> nextGroup = 0;
+	auto solve = [this, &groups, &interaction, &nextGroup, &eat, &mtx]() {
+		CellGroup group;
+		vector<PlayerCell*> members;
+		vector<GroupContact> contacts;
+		vector<pair<PlayerCell*, PlayerCell*>> pushes;
+		list<pair<Cell*, Cell*>> thread_eat;
+		unsigned int next;
+		while ((next = nextGroup++) < groups.size()) {
+			auto player = groups[next];
+			members.assign(player->ownedCells.begin(), player->ownedCells.end());
+			group.resize(members.size());
+			for (unsigned int i = 0; i < group.count; i++) {
+				group.x[i] = members[i]->getX();
+				group.y[i] = members[i]->getY();
+				group.size[i] = members[i]->getSize();
 			}
+			findGroupContacts(group, contacts);
+
+			pushes.clear();
+			for (auto& contact : contacts) {
+				auto a = members[contact.a], b = members[contact.b];
+				if (!a->probe && !b->probe) continue;
+				// Marked inside the way the contact test of the probe pass marks a pair seen from both sides
+				float sizeA = group.size[contact.a], sizeB = group.size[contact.b];
+				if (sizeA > sizeB) {
+					if (contact.dSq < sizeA) b->inside = true;
+				} else if (sizeB > sizeA) {
+					if (contact.dSq < sizeB) a->inside = true;
+				} else if (contact.dSq < sizeA) a->inside = b->inside = true;
+
+				auto result = playerEatResult(interaction, a, b);
+				if (result == EatResult::EAT) {
+					thread_eat.push_back(std::make_pair(a, b));
+					thread_eat.push_back(std::make_pair(b, a));
+				} else if (result == EatResult::COLLIDE) pushes.push_back(std::make_pair(a, b));
+			}
+
+			// Only this worker holds the player. Later checks of its own cells within a tick find
+			// the same flags the first one left, so one check stands for all the pairs.
+			PlayerCell* pushedA = nullptr;
+			PlayerCell* pushedB = nullptr;
+			for (auto [a, b] : pushes)
+				if (pushApart(a, b) && !pushedA) pushedA = a, pushedB = b;
+			if (pushedA) checkLineLock(player, pushedA, pushedB);
 		}
-		
-	} // End of owner check block
-	// ---- END MODIFICATION ----
+		mtx.lock();
+		eat.splice(eat.end(), thread_eat);
+		mtx.unlock();
+	};
 
-	a->setX(a->getX() + final_push_ax);
-	a->setY(a->getY() + final_push_ay);
-	b->setX(b->getX() + final_push_bx);
-	b->setY(b->getY() + final_push_by);
-	
-	bounceCell(a);
-	bounceCell(b);
-	updateCell(a);
-	updateCell(b);
+	unsigned int threads = std::min((unsigned int) std::max(1, handle->runtime.physicsThreads), (unsigned int) groups.size());
+	if (threads == 1) {
+		solve();
+		return;
+	}
+	for (unsigned int offset = 0; offset < threads; offset++)
+		physicsPool->enqueue([&solve]() { solve(); });
+	physicsPool->waitFinished();
+}
+
+// Rigid pairs are put in waves, a pair going one wave after the last one that touched either
+// of its cells. No cell is in a wave twice and each cell meets its pairs in the given order,
+// so running the waves one after another on the physics pool ends the same as the plain loop.
+// Pairs in a wave may still share an owner, so the waves only push. Linelock checks for pairs
+// of one owner follow on the tick thread in list order, once the last wave is done.
+void World::resolveRigidPairs(list<pair<Cell*, Cell*>>& rigid) {
+	if (rigid.empty()) return;
+	vector<unsigned int> cellWave(cells.size(), 0);
+	vector<unsigned int> pairWave;
+	pairWave.reserve(rigid.size());
+	unsigned int waves = 0;
+	for (auto [a, b] : rigid) {
+		unsigned int wave = std::max(cellWave[a->index], cellWave[b->index]) + 1;
+		cellWave[a->index] = cellWave[b->index] = wave;
+		pairWave.push_back(wave);
+		waves = std::max(waves, wave);
+	}
+
+	// Counting sort by wave, waves[w] starts at first[w]. slot maps list order to sorted order.
+	vector<unsigned int> first(waves + 2, 0);
+	for (auto wave : pairWave) first[wave + 1]++;
+	for (unsigned int w = 1; w <= waves + 1; w++) first[w] += first[w - 1];
+	vector<pair<Cell*, Cell*>> sorted(rigid.size());
+	vector<unsigned int> slot(rigid.size());
+	vector<unsigned int> fill(first.begin(), first.end() - 1);
+	unsigned int i = 0;
+	for (auto& p : rigid) {
+		slot[i] = fill[pairWave[i]]++;
+		sorted[slot[i]] = p;
+		i++;
+	}
+
+	vector<unsigned char> pushed(sorted.size(), 0);
+	unsigned int threads = std::max(1, handle->runtime.physicsThreads);
+	for (unsigned int w = 1; w <= waves; w++) {
+		unsigned int begin = first[w], end = first[w + 1];
+		if (end - begin < RIGID_WAVE_SPLIT || threads == 1) {
+			for (unsigned int p = begin; p < end; p++)
+				pushed[p] = pushApart(sorted[p].first, sorted[p].second);
+			continue;
+		}
+		for (unsigned int offset = 0; offset < threads; offset++) {
+			unsigned int from = begin + (end - begin) * offset / threads;
+			unsigned int to = begin + (end - begin) * (offset + 1) / threads;
+			physicsPool->enqueue([this, from, to, &sorted, &pushed]() {
+				for (unsigned int p = from; p < to; p++)
+					pushed[p] = pushApart(sorted[p].first, sorted[p].second);
+			});
+		}
+		physicsPool->waitFinished();
+	}
+
+	i = 0;
+	for (auto [a, b] : rigid)
+		if (pushed[slot[i++]] && a->owner && a->owner == b->owner) checkLineLock(a->owner, a, b);
 }
 
 void World::resolveEatCheck(Cell* a, Cell* b) {
-	if (!a->exist || !b->exist) return;
+	if (!eatCell(a, b)) return;
+	removeCell(b);
+	updateCell(a);
+}
+
+// Pairs go in the old size minus age order, keys are worked out once instead of per compare.
+// A pair whose cells are in no other pair cannot change or be changed by the rest, so those
+// are eaten on the physics pool first. Removal and the contested pairs then follow serially
+// in the sorted order, leaving cells and outcomes as they were with the plain loop.
+void World::resolveEatPairs(list<pair<Cell*, Cell*>>& eat) {
+	if (eat.empty()) return;
+	struct EatPair { float key; Cell* a; Cell* b; };
+	vector<EatPair> sorted;
+	sorted.reserve(eat.size());
+	for (auto [a, b] : eat)
+		sorted.push_back({ a->getSize() - a->getAge() * 0.1f, a, b });
+	std::stable_sort(sorted.begin(), sorted.end(), [](const EatPair& pairA, const EatPair& pairB) {
+		return pairA.key > pairB.key;
+	});
+
+	vector<unsigned char> seen(cells.size(), 0);
+	for (auto& p : sorted) {
+		if (seen[p.a->index] < 2) seen[p.a->index]++;
+		if (seen[p.b->index] < 2) seen[p.b->index]++;
+	}
+	// Viruses and mother cells spawn cells when they eat or get eaten, keep them on this thread
+	auto alone = [&seen](Cell* c) {
+		auto type = c->getType();
+		return seen[c->index] == 1 && type != CellType::VIRUS && type != CellType::MOTHER_CELL;
+	};
+	vector<unsigned char> state(sorted.size(), 0); // 0 contested, 1 not eaten, 2 eaten
+	vector<unsigned int> free;
+	for (unsigned int i = 0; i < sorted.size(); i++)
+		if (alone(sorted[i].a) && alone(sorted[i].b)) free.push_back(i), state[i] = 1;
+
+	unsigned int threads = std::max(1, handle->runtime.physicsThreads);
+	if (free.size() < EAT_SPLIT || threads == 1) {
+		for (auto i : free)
+			if (eatCell(sorted[i].a, sorted[i].b)) state[i] = 2;
+	} else {
+		for (unsigned int offset = 0; offset < threads; offset++) {
+			unsigned int from = free.size() * offset / threads;
+			unsigned int to = free.size() * (offset + 1) / threads;
+			physicsPool->enqueue([this, from, to, &free, &sorted, &state]() {
+				for (unsigned int f = from; f < to; f++) {
+					auto i = free[f];
+					if (eatCell(sorted[i].a, sorted[i].b)) state[i] = 2;
+				}
+			});
+		}
+		physicsPool->waitFinished();
+	}
+
+	for (unsigned int i = 0; i < sorted.size(); i++) {
+		if (state[i] == 1) continue;
+		if (state[i] == 0) {
+			resolveEatCheck(sorted[i].a, sorted[i].b);
+			continue;
+		}
+		removeCell(sorted[i].b);
+		updateCell(sorted[i].a);
+	}
+}
+
+// Eat b into a when they still overlap enough, removing b is left to the caller
+bool World::eatCell(Cell* a, Cell* b) {
+	if (!a->exist || !b->exist) return false;
 
     // --- BEGIN DUAL PLAYER EAT IMMUNITY (REMOVED) ---
     /*
@@ -818,8 +1347,8 @@ void World::resolveEatCheck(Cell* a, Cell* b) {
 	float dx_dist = b->getX() - a->getX();
 	float dy_dist = b->getY() - a->getY();
 	float d_dist = sqrt(dx_dist * dx_dist + dy_dist * dy_dist);
-	if (d_dist > a->getSize() - b->getSize() / handle->runtime.worldEatOverlapDiv) return;
-	if (!handle->gamemode->canEat(a, b)) return;
+	if (d_dist > a->getSize() - b->getSize() / handle->runtime.worldEatOverlapDiv) return false;
+	if (!handle->gamemode->canEat(a, b)) return false;
 
 	// --- BEGIN USER'S BOOST ABSORPTION LOGIC (Snippet 1) ---
 	bool can_absorb_boost = (b->boost.d > 0.0f);
@@ -857,14 +1386,350 @@ void World::resolveEatCheck(Cell* a, Cell* b) {
 		// If norm_sq is zero, old a->boost.dx/dy are preserved.
 	}
 	// cell->flag |= UPDATE_BIT; is effectively handled by updateCell(a) later.
-	// TODO: Implement `other->eatenByID = cell_id(cell);` (requires Cell class modification for eatenByID).
-	// Example: uint32_t eater_id_for_b = a->id;
 	// --- END USER'S BOOST ABSORPTION LOGIC ---
 
 	a->whenAte(b);
 	b->whenEatenBy(a);
-	removeCell(b);
-	updateCell(a);
+	return true;
+}
+
+static inline void anchorCell(Cell* cell) {
+	cell->anchorX = cell->getX();
+	cell->anchorY = cell->getY();
+	cell->anchorSize = cell->getSize();
+	cell->anchored = true;
+}
+
+// Whether cell moved and grew by more than limit in total since it was anchored
+static inline bool cellDrifted(Cell* cell, float limit) {
+	float grown = std::abs(cell->getSize() - cell->anchorSize);
+	if (grown > limit) return true;
+	float dx = cell->getX() - cell->anchorX;
+	float dy = cell->getY() - cell->anchorY;
+	return dx * dx + dy * dy > (limit - grown) * (limit - grown);
+}
+
+// Verlet style neighbour lists: a probe's list holds everything within its size plus verletSkin
+// when it was built. While the probe and every cell around it drift less than a quarter skin
+// from their anchors, any pair that touches now was within the skin of the later of the two
+// anchors, so the list can stand in for a tree query. Probes past that are queried again, and
+// cells that do not probe but moved, appeared or stopped probing are pushed into the kept lists.
+void World::refreshNeighbours(vector<Cell*>& probes) {
+	auto tick = handle->tick;
+	float limit = verletSkin / 4;
+	vector<Cell*> stale;
+	vector<CircleBorder> staleCircles;
+	for (auto c : probes) {
+		bool kept = c->listTick && c->probedTick + 1 == tick &&
+			tick - c->listTick < NEIGHBOUR_MAX_AGE && !cellDrifted(c, limit);
+		c->probedTick = tick;
+		if (kept) continue;
+		c->listTick = tick;
+		anchorCell(c);
+		stale.push_back(c);
+		staleCircles.push_back(CircleBorder(c->getX(), c->getY(), c->getSize() + verletSkin));
+	}
+
+	unsigned int threads = std::max(1, handle->runtime.physicsThreads);
+	unsigned int chunk = std::max(32u, (unsigned int) stale.size() / (threads * 8));
+	atomic<unsigned int> nextStale = 0;
+	for (unsigned int offset = 0; offset < threads; offset++) {
+		physicsPool->enqueue([this, chunk, &nextStale, &stale, &staleCircles]() {
+			unsigned int begin;
+			while ((begin = nextStale.fetch_add(chunk)) < stale.size()) {
+				unsigned int end = std::min(begin + chunk, (unsigned int) stale.size());
+				for (unsigned int i = begin; i < end; i++) stale[i]->neighbours.clear();
+				finder->searchBatch(staleCircles.data() + begin, end - begin,
+					[&stale, begin](unsigned int index, QuadItem* o) {
+					auto c = stale[begin + index];
+					if (o != c) c->neighbours.push_back((Cell*) o);
+					return false;
+				});
+			}
+		});
+	}
+
+	unsigned int pushed = 0;
+	for (auto c : cells) {
+		if (!c->exist || c->probe) continue;
+		if (c->anchored && c->probedTick + 1 != tick && !cellDrifted(c, limit)) continue;
+		anchorCell(c);
+		Rect reach(c->getX(), c->getY(), c->getSize() + verletSkin, c->getSize() + verletSkin);
+		finder->search(reach, QUAD_ANY & ~cellTypeMask(CellType::PELLET), [c, tick, this](QuadItem* o) {
+			auto probe = (Cell*) o;
+			// Lists built this tick find c themselves
+			if (!probe->probe || probe->listTick == tick) return false;
+			float dx = probe->getX() - c->getX();
+			float dy = probe->getY() - c->getY();
+			float reach = probe->getSize() + c->getSize() + verletSkin;
+			if (dx * dx + dy * dy >= reach * reach) return false;
+			auto& list = probe->neighbours;
+			if (std::find(list.begin(), list.end(), c) == list.end()) list.push_back(c);
+			return true;
+		});
+		pushed++;
+	}
+	physicsPool->waitFinished();
+
+	handle->timing.neighbourReuse = probes.size() ? 1.0f - static_cast<float>(stale.size()) / probes.size() : 0.0f;
+	handle->timing.neighbourRebuilds = static_cast<float>(stale.size());
+	handle->timing.neighbourPushes = static_cast<float>(pushed);
+}
+
+// Cells of worldEatBulkSize and up swallow whole quadtree subtrees of pellets lying inside them,
+// so those pellets never go through the collision pass and eat queue one pair at a time. This
+// runs before the collision pass, so an eater that eats or gets eaten by anything but a pellet
+// this tick is left out: its pellets wait for the eat queue, which keeps that eat from seeing
+// the pellet mass early, and an eater that gets eaten leaves its pellets behind as it used to.
+void World::bulkEatPellets() {
+	auto tree = static_cast<QuadTree*>(finder);
+	vector<Cell*> eaters;
+	auto& states = cellStates;
+	for (unsigned int i = 0; i < cells.size(); i++)
+		if (states.type[i] == CellType::PLAYER && states.ownerId[i] && states.size[i] >= handle->runtime.worldEatBulkSize)
+			eaters.push_back(cells[i]);
+	if (eaters.empty()) return;
+
+	// Judged by the rules and contact test the collision pass uses for the eater's pairs
+	auto interaction = getInteractionParams();
+	const unsigned char others = ~cellTypeMask(CellType::PELLET);
+	eaters.erase(std::remove_if(eaters.begin(), eaters.end(), [this, others, &interaction](Cell* eater) {
+		return finder->containAny(eater->range, others, [&interaction, eater](QuadItem* o) {
+			auto other = (Cell*) o;
+			if (other == eater || !other->exist) return false;
+			auto dx = eater->getX() - other->getX();
+			auto dy = eater->getY() - other->getY();
+			auto reach = eater->getSize() + other->getSize();
+			if (dx * dx + dy * dy >= reach * reach) return false;
+			auto forward = getEatResult(interaction, eater, other);
+			auto backward = getEatResult(interaction, other, eater);
+			return forward == EatResult::EAT || forward == EatResult::EATINVD ||
+				backward == EatResult::EAT || backward == EatResult::EATINVD;
+		});
+	}), eaters.end());
+
+	// Same priority as the eat queue
+	std::sort(eaters.begin(), eaters.end(), [](Cell* a, Cell* b) {
+		return (a->getSize() - a->getAge() * 0.1f) > (b->getSize() - b->getAge() * 0.1f);
+	});
+
+	for (auto eater : eaters) {
+		float gained = 0.0f;
+		CircleBorder reach(eater->getX(), eater->getY(), eater->getSize());
+		auto eaten = tree->consume(reach, cellTypeMask(CellType::PELLET), [this, eater, &gained](QuadItem* item) {
+			auto pellet = (Cell*) item;
+			// Boosted pellets hand boost to the eater, leave them to resolveEatCheck
+			if (pellet->boost.d > 0.0f || !handle->gamemode->canEat(eater, pellet)) return false;
+			gained += pellet->getSquareSize();
+			pellet->whenEatenBy(eater);
+			removeCell(pellet);
+			return true;
+		});
+		if (!eaten) continue;
+		eater->setSquareSize(eater->getSquareSize() + gained);
+		updateCell(eater);
+	}
+}
+
+// Runs job over [0, count) in one slice per physics thread, short ranges stay on this thread.
+// Slices start on multiples of step.
+void World::forEachSlice(unsigned int count, const std::function<void(unsigned int, unsigned int)>& job, unsigned int step) {
+	unsigned int threads = std::max(1, handle->runtime.physicsThreads);
+	if (count < INTEGRATE_SPLIT || threads == 1) {
+		job(0, count);
+		return;
+	}
+	for (unsigned int offset = 0; offset < threads; offset++) {
+		unsigned int from = count * offset / threads / step * step;
+		unsigned int to = offset + 1 == threads ? count : count * (offset + 1) / threads / step * step;
+		physicsPool->enqueue([&job, from, to]() { job(from, to); });
+	}
+	physicsPool->waitFinished();
+}
+
+// Pellets grow a unit of mass every period ticks of age, starting one period after their birth
+unsigned long World::pelletGrowthPeriod() {
+	return handle->runtime.pelletGrowTicks / handle->stepMult + 1;
+}
+
+void World::addGrowingPellet(Pellet* pellet) {
+	if (handle->runtime.pelletMinSize >= handle->runtime.pelletMaxSize) return;
+	auto period = pelletGrowthPeriod();
+	if (pelletGrowth.size() != period) bucketPellets(period);
+	pelletGrowth[pellet->birthTick % period].push_back(pellet->handle);
+}
+
+// Sorts the growing pellets into buckets for a new period, the first call makes the buckets
+void World::bucketPellets(unsigned long period) {
+	vector<CellHandle> waiting;
+	for (auto& bucket : pelletGrowth) waiting.insert(waiting.end(), bucket.begin(), bucket.end());
+	pelletGrowth.assign(period, {});
+	for (auto h : waiting)
+		if (auto pellet = getCell(h)) pelletGrowth[pellet->birthTick % period].push_back(h);
+}
+
+// Only the bucket of pellets due this tick is visited, each pellet's size comes from its age in
+// closed form. Pellets eaten since they were bucketed no longer resolve and are dropped here.
+void World::growPellets() {
+	auto& runtime = handle->runtime;
+	auto period = pelletGrowthPeriod();
+	if (pelletGrowth.size() != period) bucketPellets(period);
+
+	float minMass = runtime.pelletMinSize * runtime.pelletMinSize / 100.0f;
+	float maxMass = runtime.pelletMaxSize * runtime.pelletMaxSize / 100.0f;
+	unsigned long steps = maxMass > minMass ? static_cast<unsigned long>(ceilf(maxMass - minMass)) : 0;
+
+	auto& bucket = pelletGrowth[handle->tick % period];
+	unsigned int kept = 0;
+	for (auto h : bucket) {
+		auto pellet = getCell(h);
+		if (!pellet) continue;
+		auto grown = std::min((handle->tick - pellet->birthTick) / period, steps);
+		pellet->setMass(minMass + grown);
+		updateCell(pellet);
+		if (grown < steps) bucket[kept++] = h;
+	}
+	bucket.resize(kept);
+}
+
+// Boosts only move the boosted cell, so they run on the physics pool. Returns how many cells
+// were flagged inside another last tick.
+unsigned int World::boostCells() {
+	atomic<unsigned int> insides = 0;
+	forEachSlice(cells.size(), [this, &insides](unsigned int from, unsigned int to) {
+		unsigned int inside = 0;
+		for (unsigned int i = from; i < to; i++) {
+			if (cellStates.type[i] == CellType::PELLET) continue;
+			auto c = cells[i];
+			// Ejected cells only get boost when ejected, moveParticles moves them
+			if (cellStates.type[i] != CellType::EJECTED_CELL) boostCell(c);
+			if (c->inside) {
+				c->inside = false;
+				inside++;
+			}
+		}
+		insides += inside;
+	});
+	return insides;
+}
+
+// Ejected cells in flight, integrated as a batch with the steps boostCell takes for one cell.
+// Particles that landed or were eaten leave the list here.
+void World::moveParticles() {
+	unsigned int count = 0;
+	for (auto p : particles)
+		if (p->exist && p->isBoosting()) particles[count++] = p;
+	particles.resize(count);
+
+	ParticleParams params;
+	params.stepMult = handle->stepMult;
+	params.left = border.getX() - border.w;
+	params.right = border.getX() + border.w;
+	params.bottom = border.getY() - border.h;
+	params.top = border.getY() + border.h;
+
+	auto& batch = particleBatch;
+	batch.resize(count);
+	forEachSlice(count, [this, &batch, &params](unsigned int from, unsigned int to) {
+		for (unsigned int i = from; i < to; i++) {
+			auto p = particles[i];
+			batch.x[i] = p->getX();
+			batch.y[i] = p->getY();
+			batch.dx[i] = p->boost.dx;
+			batch.dy[i] = p->boost.dy;
+			batch.d[i] = p->boost.d;
+			batch.size[i] = p->getSize();
+		}
+		integrateParticles(batch, params, from, to);
+		for (unsigned int i = from; i < to; i++) {
+			auto p = particles[i];
+			p->setX(batch.x[i]);
+			p->setY(batch.y[i]);
+			p->boost = { batch.dx[i], batch.dy[i], batch.d[i] };
+			updateCell(p);
+		}
+	});
+}
+
+// Moving, decaying and clamping only touch the cell itself, they run through the player cell
+// kernels over a struct-of-arrays copy, sliced over the physics pool. Cells big enough to
+// autosplit are left unclamped, since splitting adds cells and draws random angles: the
+// serial merge splits them in cell order like the plain loop did. Cells split off this tick
+// are updated after all others, also as before.
+void World::updatePlayerCells() {
+	unsigned int count = cells.size();
+	playerCells.clear();
+	for (unsigned int i = 0; i < count; i++)
+		if (cells[i]->getType() == CellType::PLAYER) playerCells.push_back(static_cast<PlayerCell*>(cells[i]));
+
+	auto& runtime = handle->runtime;
+	PlayerCellParams params;
+	params.moveMult = runtime.playerMoveMult;
+	params.stepMult = handle->stepMult;
+	params.decayMult = runtime.playerDecayMult;
+	params.minSize = runtime.playerMinSize;
+	params.splitSquareSize = runtime.playerMaxSize * runtime.playerMaxSize;
+	params.left = border.getX() - border.w;
+	params.right = border.getX() + border.w;
+	params.bottom = border.getY() - border.h;
+	params.top = border.getY() + border.h;
+
+	auto& batch = playerBatch;
+	batch.resize(playerCells.size());
+	vector<unsigned char> splits(playerCells.size(), 0);
+	forEachSlice(batch.padded(), [this, &batch, &params, &splits](unsigned int from, unsigned int to) {
+		unsigned int end = std::min(to, batch.count);
+		for (unsigned int i = from; i < end; i++) {
+			auto pc = playerCells[i];
+			batch.x[i] = pc->getX();
+			batch.y[i] = pc->getY();
+			batch.size[i] = pc->getSize();
+			auto owner = pc->owner;
+			if (!owner) continue;
+			batch.flags[i] = PLAYER_OWNED;
+			if (owner->router->disconnected) continue;
+			batch.flags[i] |= PLAYER_MOVES;
+			batch.targetX[i] = owner->router->mouseX;
+			batch.targetY[i] = owner->router->mouseY;
+			if (owner->isLineLocked && fabsf(owner->lineEqDenomInv) > 1e-5f && (pc->cellFlags & LOCK_BIT)) {
+				batch.flags[i] |= PLAYER_LOCKED;
+				batch.lineA[i] = owner->lineEqA;
+				batch.lineB[i] = owner->lineEqB;
+				batch.lineC[i] = owner->lineEqC;
+				batch.lineInv[i] = owner->lineEqDenomInv;
+			}
+		}
+		integratePlayerCells(batch, params, from, to);
+		for (unsigned int i = from; i < end; i++) {
+			auto pc = playerCells[i];
+			pc->setX(batch.x[i]);
+			pc->setY(batch.y[i]);
+			pc->setSize(batch.size[i]);
+			if ((batch.flags[i] & PLAYER_OWNED) && pc->getSquareSize() > params.splitSquareSize) {
+				splits[i] = 1;
+				continue;
+			}
+			updateCell(pc);
+		}
+	}, PLAYER_BATCH_LANES);
+
+	for (unsigned int i = 0; i < playerCells.size(); i++) {
+		if (!splits[i]) continue;
+		auto pc = playerCells[i];
+		autosplitPlayerCell(pc);
+		bounceCell(pc);
+		updateCell(pc);
+	}
+	for (unsigned int i = count; i < cells.size(); i++) {
+		auto c = cells[i];
+		if (c->getType() != CellType::PLAYER) continue;
+		auto pc = static_cast<PlayerCell*>(c);
+		movePlayerCell(pc);
+		decayPlayerCell(pc);
+		autosplitPlayerCell(pc);
+		bounceCell(pc);
+		updateCell(pc);
+	}
 }
 
 void World::boostCell(Cell* cell) {
@@ -873,8 +1738,8 @@ void World::boostCell(Cell* cell) {
 	cell->setX(cell->getX() + cell->boost.dx * d);
 	cell->setY(cell->getY() + cell->boost.dy * d);
 	bounceCell(cell, true);
-	updateCell(cell);
 	cell->boost.d -= d;
+	updateCell(cell);
 }
 
 void World::bounceCell(Cell* cell, bool bounce) {
@@ -898,7 +1763,7 @@ void World::bounceCell(Cell* cell, bool bounce) {
 }
 
 void World::splitVirus(Virus* virus) {
-	auto newVirus = new Virus(this, virus->getX(), virus->getY());
+	auto newVirus = pools.viruses.create(this, virus->getX(), virus->getY());
 	newVirus->boost.dx = sin(virus->splitAngle);
 	newVirus->boost.dy = cos(virus->splitAngle);
 	newVirus->boost.d = handle->runtime.virusSplitBoost;
@@ -972,7 +1837,7 @@ void World::launchPlayerCell(PlayerCell* cell, float size, Boost& boost) {
 	cell->setSquareSize(cell->getSquareSize() - size * size);
 	float x = cell->getX() + handle->runtime.playerSplitDistance * boost.dx;
 	float y = cell->getY() + handle->runtime.playerSplitDistance * boost.dy;
-	auto newCell = new PlayerCell(this, cell->owner, x, y, size);
+	auto newCell = pools.players.create(this, cell->owner, x, y, size);
 	newCell->boost = boost;
 	addCell(newCell);
 }
@@ -1047,12 +1912,13 @@ void World::ejectFromPlayer(Player* player) {
 		else dx /= d, dy /= d;
 		float sx = cell->getX() + dx * cell->getSize();
 		float sy = cell->getY() + dy * cell->getSize();
-		auto newCell = new EjectedCell(this, player, sx, sy, cell->getColor());
+		auto newCell = pools.ejected.create(this, player, sx, sy, cell->getColor());
 		float a = atan2(dx, dy) - dispersion + randomZeroToOne * 2 * dispersion;
 		newCell->boost.dx = sin(a);
 		newCell->boost.dy = cos(a);
 		newCell->boost.d = handle->runtime.ejectedCellBoost;
 		addCell(newCell);
+		particles.push_back(newCell);
 		cell->setSquareSize(cell->getSquareSize() - loss);
 		updateCell(cell);
 		ejectCount++;
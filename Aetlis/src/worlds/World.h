@@ -2,6 +2,7 @@
 
 #include <vector>
 #include <list>
+#include <functional>
 #include "../sockets/ChatChannel.h"
 #include "../primitives/Rect.h"
 #include "../primitives/SimplePool.h"
@@ -11,9 +12,14 @@ struct SpawnResult {
 	Point pos;
 };
 
-#include "../primitives/QuadTree.h"
+#include "../primitives/Finders.h"
+#include "../primitives/QuadTreeTuner.h"
 #include "../cells/Cell.h"
+#include "../cells/CellPool.h"
+#include "../cells/CellKernels.h"
+#include "../cells/Interactions.h"
 #include "Player.h"
+#include "CellStates.h"
 
 struct WorldStats {
 	unsigned short limit = 0;
@@ -37,8 +43,14 @@ public:
 	unsigned int _nextCellId = 1;
 	unsigned ejectCount = 0;
 	
-	list<Cell*> gcTruck;
-	list<Cell*> cells;
+	// Every cell of this world is made by these, see removeCell and releaseCells for their lifetime
+	CellPools pools;
+	// Contiguous so physics can slice it, removed cells are swap-removed by compactCells
+	std::vector<Cell*> cells;
+	CellStates cellStates;
+	std::vector<Cell*> removedCells;
+	// Handles of pellets still growing, bucketed by birth tick modulo the growth period
+	std::vector<std::vector<CellHandle>> pelletGrowth;
 	list<Player*> players;
 	Player* largestPlayer = nullptr;
 
@@ -49,8 +61,24 @@ public:
 	int virusCount = 0;
 	Rect border;
 
-	QuadTree* finder = nullptr;
+	Finder* finder = nullptr;
 	QuadTree* lockedFinder = nullptr;
+	// Rebuild the quadtree from Morton sorted cells every tick instead of updating it per cell
+	bool finderRebuild = false;
+	// Flushes drop their updates instead, the tree is rebuilt from scratch
+	bool deferFinderUpdates = false;
+	std::vector<Cell*> dirtyCells;
+	std::vector<MortonItem> mortonCells;
+	bool finderAutoTune = false;
+	QuadTreeTuner finderTuner;
+	// Probes reuse collision candidates found this far past their size, 0 queries every tick
+	float verletSkin = 0;
+	// Player cells of this tick and their struct-of-arrays copy for the integration kernels
+	std::vector<PlayerCell*> playerCells;
+	PlayerCellBatch playerBatch;
+	// Ejected cells in flight and their struct-of-arrays copy, see moveParticles
+	std::vector<EjectedCell*> particles;
+	ParticleBatch particleBatch;
 
 	WorldStats stats;
 
@@ -59,9 +87,15 @@ public:
 	unsigned int getNextCellId() { return _nextCellId > 4294967295U ? (_nextCellId = 1) : _nextCellId++; };
 	void afterCreation();
 	void setBorder(Rect& rect);
+	Cell* getCell(CellHandle handle) { return pools.get(handle); };
 	void addCell(Cell* cell);
 	void updateCell(Cell* cell);
+	void flushFinderUpdates();
 	void removeCell(Cell* cell);
+	void compactCells();
+	void rebuildFinder();
+	void compileFinderStats();
+	void refreshNeighbours(std::vector<Cell*>& probes);
 	void addPlayer(Player* player);
 	void killPlayer(Player* player, bool instantKill = false);
 	void removePlayer(Player* player);
@@ -74,8 +108,24 @@ public:
 	void update() { frozen ? frozenUpdate() : liveUpdate(); };
 	void frozenUpdate();
 	void liveUpdate();
+	unsigned long pelletGrowthPeriod();
+	void addGrowingPellet(Pellet* pellet);
+	void bucketPellets(unsigned long period);
+	void growPellets();
+	InteractionParams getInteractionParams();
 	void resolveRigidCheck(Cell* a, Cell* b);
+	bool pushApart(Cell* a, Cell* b);
+	void checkLineLock(Player* commonOwner, Cell* a, Cell* b);
+	void solvePlayerGroups(std::list<std::pair<Cell*, Cell*>>& eat);
+	void resolveRigidPairs(std::list<std::pair<Cell*, Cell*>>& rigid);
 	void resolveEatCheck(Cell* a, Cell* b);
+	void resolveEatPairs(std::list<std::pair<Cell*, Cell*>>& eat);
+	bool eatCell(Cell* a, Cell* b);
+	void bulkEatPellets();
+	void forEachSlice(unsigned int count, const std::function<void(unsigned int, unsigned int)>& job, unsigned int step = 1);
+	unsigned int boostCells();
+	void moveParticles();
+	void updatePlayerCells();
 	void boostCell(Cell* cell);
 	void bounceCell(Cell* cell, bool bounce = false);
 	void splitVirus(Virus* virus);
@@ -88,6 +138,6 @@ public:
 	void popPlayerCell(PlayerCell* cell);
 	void distributeCellMass(PlayerCell* cell, std::vector<float>& ref);
 	void compileStatistics();
-	void clearTruck();
+	void releaseCells();
 	void restart();
 };
\ No newline at end of file